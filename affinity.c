@@ -0,0 +1,198 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#define _GNU_SOURCE
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "affinity.h"
+#include "options.h"
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * A processor the workers may run on: its socket, its core on the socket,
+ * its rank among the hardware threads of the core and the rank of the core
+ * among the cores of the socket.
+ */
+struct Processor {
+    int cpu;
+    int socket;
+    int core;
+    int sibling;
+    int slot;
+};
+
+typedef struct Processor Processor;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static int read_topology(int cpu, char * name);
+static int compare_compact(const void * a, const void * b);
+static int compare_scatter(const void * a, const void * b);
+
+
+/**
+ * Orders the processors the process may run on for a binding policy.
+ * `compact` fills a socket core by core before the next one, so workers
+ * close in number share caches; `scatter` spreads consecutive workers over
+ * the sockets first, then over the cores of every socket, and puts a second
+ * worker on a core only once every core has one.
+ *
+ * @param bind BIND_NONE, BIND_COMPACT or BIND_SCATTER.
+ * @return Returns the placement of the workers, or NULL if they are left unbound.
+ */
+Affinity * affinity_create(int bind){
+#ifdef __linux__
+    cpu_set_t allowed;
+    if (bind == BIND_NONE || sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+        return NULL;
+    }
+    int count = CPU_COUNT(&allowed);
+    if (count <= 0){
+        return NULL;
+    }
+
+    Processor * processors = malloc(count * sizeof(Processor));
+    int cpu, i = 0, j;
+    for (cpu = 0; cpu < CPU_SETSIZE && i < count; ++cpu){
+        if (CPU_ISSET(cpu, &allowed)){
+            processors[i].cpu = cpu;
+            processors[i].socket = read_topology(cpu, "physical_package_id");
+            processors[i].core = read_topology(cpu, "core_id");
+            i++;
+        }
+    }
+    for (i = 0; i < count; ++i){
+        processors[i].sibling = 0;
+        for (j = 0; j < i; ++j){
+            processors[i].sibling += processors[j].socket == processors[i].socket &&
+                                     processors[j].core == processors[i].core;
+        }
+    }
+    for (i = 0; i < count; ++i){
+        processors[i].slot = 0;
+        for (j = 0; j < count; ++j){
+            processors[i].slot += processors[j].socket == processors[i].socket && processors[j].sibling == 0 &&
+                                  processors[j].core < processors[i].core;
+        }
+    }
+    qsort(processors, count, sizeof(Processor), bind == BIND_COMPACT ? compare_compact : compare_scatter);
+
+    Affinity * affinity = malloc(sizeof(Affinity));
+    affinity->count = count;
+    affinity->cpus = malloc(count * sizeof(int));
+    affinity->sockets = malloc(count * sizeof(int));
+    for (i = 0; i < count; ++i){
+        affinity->cpus[i] = processors[i].cpu;
+        affinity->sockets[i] = processors[i].socket;
+    }
+    free(processors);
+    return affinity;
+#else
+    return NULL;
+#endif
+}
+
+/**
+ * Pins the calling thread to the processor of a worker. Memory the thread
+ * touches first afterwards is placed on the node of that processor.
+ *
+ * @param affinity Placement of the workers, or NULL.
+ * @param worker Index of the worker of the calling thread.
+ * @return Returns non-zero if the thread was pinned.
+ */
+int affinity_pin(Affinity * affinity, int worker){
+#ifdef __linux__
+    if (affinity == NULL){
+        return 0;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(affinity->cpus[worker % affinity->count], &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Socket of the processor of a worker.
+ *
+ * @param affinity Placement of the workers, or NULL.
+ * @param worker Index of the worker.
+ * @return Returns the socket, 0 if the workers are left unbound.
+ */
+int affinity_socket(Affinity * affinity, int worker){
+    if (affinity == NULL){
+        return 0;
+    }
+    return affinity->sockets[worker % affinity->count];
+}
+
+/**
+ * Free's the placement of the workers.
+ *
+ * @param affinity Placement to free.
+ */
+void affinity_free(Affinity * affinity){
+    if (affinity != NULL) {
+        free(affinity->cpus);
+        free(affinity->sockets);
+        free(affinity);
+    }
+}
+
+/**
+ * Reads a value of the topology of a processor from sysfs.
+ *
+ * @param cpu Index of the processor.
+ * @param name Name of the value, physical_package_id or core_id.
+ * @return Returns the value, 0 if it can not be read.
+ */
+static int read_topology(int cpu, char * name){
+    char path[128];
+    int value = 0;
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/%s", cpu, name);
+    FILE * file = fopen(path, "r");
+    if (file != NULL){
+        if (fscanf(file, "%d", &value) != 1){
+            value = 0;
+        }
+        fclose(file);
+    }
+    return value;
+}
+
+/**
+ * Orders processors by socket, then core, then hardware thread.
+ */
+static int compare_compact(const void * a, const void * b){
+    const Processor * p = a, * q = b;
+    if (p->socket != q->socket){
+        return p->socket - q->socket;
+    }
+    if (p->core != q->core){
+        return p->core - q->core;
+    }
+    return p->sibling - q->sibling;
+}
+
+/**
+ * Orders processors by hardware thread, then core slot, then socket.
+ */
+static int compare_scatter(const void * a, const void * b){
+    const Processor * p = a, * q = b;
+    if (p->sibling != q->sibling){
+        return p->sibling - q->sibling;
+    }
+    if (p->slot != q->slot){
+        return p->slot - q->slot;
+    }
+    return p->socket - q->socket;
+}
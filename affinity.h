@@ -0,0 +1,28 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Processors the workers are pinned to, worker i runs on cpus[i % count],
+ * and the socket of every one of them.
+ */
+struct Affinity {
+    int count;
+    int * cpus;
+    int * sockets;
+};
+
+typedef struct Affinity Affinity;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Affinity * affinity_create(int bind);
+int affinity_pin(Affinity * affinity, int worker);
+int affinity_socket(Affinity * affinity, int worker);
+void affinity_free(Affinity * affinity);
+
+#endif
@@ -0,0 +1,90 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "board.h"
+
+
+/**
+ * Creates an empty board.
+ *
+ * @param root_n Square root of the number of rows and columns.
+ * @return Returns the new board, with every cell empty.
+ */
+Board * board_create(int root_n){
+    int n = root_n * root_n;
+    size_t bytes = offsetof(Board, cells) + (size_t) n * n;
+    // aligned_alloc wants a whole number of alignments
+    bytes = (bytes + BOARD_ALIGNMENT - 1) / BOARD_ALIGNMENT * BOARD_ALIGNMENT;
+
+    Board * board = aligned_alloc(BOARD_ALIGNMENT, bytes);
+    memset(board, 0, bytes);
+    board->root_n = root_n;
+    board->n = n;
+    board->bytes = bytes;
+    return board;
+}
+
+/**
+ * Reads a board in the input format, the square root of n on the first
+ * line followed by n lines of n numbers.
+ *
+ * @param file File to read from.
+ * @return Returns the board, or NULL if the file does not hold one.
+ */
+Board * board_read(FILE * file){
+    int root_n;
+    if (fscanf(file, "%d", &root_n) != 1 || root_n < 1 || root_n * root_n > UINT8_MAX){
+        return NULL;
+    }
+
+    Board * board = board_create(root_n);
+    int cell, number;
+    for (cell = 0; cell < board->n * board->n; ++cell){
+        if (fscanf(file, "%d", &number) != 1 || number < 0 || number > board->n){
+            board_free(board);
+            return NULL;
+        }
+        board->cells[cell] = number;
+    }
+    return board;
+}
+
+/**
+ * Creates a copy of a board.
+ *
+ * @param board Board to copy.
+ * @return Returns the new board.
+ */
+Board * board_copy(Board * board){
+    Board * copy = aligned_alloc(BOARD_ALIGNMENT, board->bytes);
+    memcpy(copy, board, board->bytes);
+    return copy;
+}
+
+/**
+ * Prints a board, one row per line with every number followed by a space.
+ *
+ * @param file File to print to.
+ * @param board Board to print.
+ */
+void board_print(FILE * file, Board * board){
+    int row, column;
+    for (row = 0; row < board->n; ++row){
+        for (column = 0; column < board->n; ++column){
+            fprintf(file, "%d ", board_get(board, row, column));
+        }
+        fprintf(file, "\n");
+    }
+}
+
+/**
+ * Free's a board.
+ *
+ * @param board Board to free.
+ */
+void board_free(Board * board){
+    free(board);
+}
@@ -0,0 +1,76 @@
+#ifndef BOARD_H
+#define BOARD_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// boards start and end on a cache line
+#define BOARD_ALIGNMENT 64
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Cells of a puzzle in row-major order, one byte per cell and 0 for an
+ * empty cell. The header and the cells are a single cache aligned block,
+ * so a board is copied with one allocation and one memcpy.
+ */
+struct Board {
+    int root_n;
+    int n;
+    // bytes of the whole block, header included
+    size_t bytes;
+    uint8_t cells[] __attribute__((aligned(BOARD_ALIGNMENT)));
+};
+
+typedef struct Board Board;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Board * board_create(int root_n);
+Board * board_read(FILE * file);
+Board * board_copy(Board * board);
+void board_print(FILE * file, Board * board);
+void board_free(Board * board);
+
+
+////////////////////////////////////////////////////////////
+//// Inline Functions
+////////////////////////////////////////////////////////////
+
+/**
+ * Number placed in a cell.
+ *
+ * @param board Board of the puzzle.
+ * @param row Row of the cell.
+ * @param column Column of the cell.
+ * @return Returns the number of the cell, 0 if it is empty.
+ */
+static inline int board_get(Board * board, int row, int column){
+    return board->cells[row * board->n + column];
+}
+
+/**
+ * Places a number in a cell.
+ *
+ * @param board Board of the puzzle.
+ * @param row Row of the cell.
+ * @param column Column of the cell.
+ * @param number Number to place, 0 to empty the cell.
+ */
+static inline void board_set(Board * board, int row, int column, int number){
+    board->cells[row * board->n + column] = number;
+}
+
+#endif
@@ -0,0 +1,427 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "checkpoint.h"
+#include "kernel.h"
+#include "wire.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// first bytes of a checkpoint file and version of its layout
+#define CHECKPOINT_MAGIC "SDKC"
+#define CHECKPOINT_VERSION 1
+// a branch handed to the kernel is sized to take about this share of the checkpoint interval
+#define LEAF_SHARE 100
+// and given up on once it takes this many shares, a quarter of the interval
+#define LEAF_GIVE_UP (LEAF_SHARE / 4)
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Header of a checkpoint file, followed by the cells of the given puzzle
+ * and by the wire messages of the subproblems.
+ */
+struct CheckpointHeader {
+    char magic[4];
+    uint8_t version;
+    uint8_t root_n;
+    uint16_t reserved;
+    uint32_t count;
+    uint64_t size;
+};
+
+/**
+ * Stop hook of a branch searched by the kernel: the stop hook of the
+ * worker, and the time the branch is given up at.
+ */
+struct LeafStop {
+    int (*stop)(void * data);
+    void * data;
+    double deadline;
+    int expired;
+};
+
+typedef struct CheckpointHeader CheckpointHeader;
+typedef struct LeafStop LeafStop;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static void reserve(Checkpoint * checkpoint, size_t size);
+static double wall_time();
+static int leaf_stop(void * data);
+
+
+/**
+ * Creates an empty checkpoint of a puzzle.
+ *
+ * @param given Puzzle as read from its file, copied.
+ * @return Returns the new checkpoint.
+ */
+Checkpoint * checkpoint_create(Board * given){
+    Checkpoint * checkpoint = malloc(sizeof(Checkpoint));
+    checkpoint->given = board_copy(given);
+    checkpoint->count = 0;
+    checkpoint->size = 0;
+    checkpoint->capacity = 0;
+    checkpoint->items = NULL;
+    return checkpoint;
+}
+
+/**
+ * Drops every subproblem, keeping the buffer for the next checkpoint.
+ *
+ * @param checkpoint Checkpoint to clear.
+ */
+void checkpoint_clear(Checkpoint * checkpoint){
+    checkpoint->count = 0;
+    checkpoint->size = 0;
+}
+
+/**
+ * Adds a subproblem.
+ *
+ * @param checkpoint Checkpoint to add to.
+ * @param cells Cells of the subproblem, same size as the given puzzle.
+ * @param depth Decisions taken from the given puzzle.
+ */
+void checkpoint_add(Checkpoint * checkpoint, uint8_t * cells, int depth){
+    reserve(checkpoint, wire_capacity(checkpoint->given->root_n));
+    checkpoint->size += wire_encode(checkpoint->items + checkpoint->size, checkpoint->given, cells, depth);
+    checkpoint->count++;
+}
+
+/**
+ * Adds every branch a suspended search has not tried yet, one subproblem
+ * per untried number of every decision on its stack: the cells on which
+ * the decision was taken with that number in its cell. Together they are
+ * what is left of the search.
+ *
+ * @param checkpoint Checkpoint to add to.
+ * @param search Suspended search.
+ * @param depth Decisions taken from the given puzzle to the state the search started on.
+ */
+void checkpoint_add_search(Checkpoint * checkpoint, Search * search, int depth){
+    if (search->status != SEARCH_SUSPENDED){
+        return;
+    }
+    Constraints * constraints = search->constraints;
+    int size = constraints->n * constraints->n;
+    uint8_t * cells = malloc(size);
+    memcpy(cells, constraints->values, size);
+
+    // the numbers placed after each decision are taken back, deepest first, without undoing the search
+    int count = search->trail->count, level;
+    for (level = search->depth - 1; level >= 0; --level){
+        Frame * frame = &search->stack[level];
+        while (count > frame->mark){
+            Change * change = &search->trail->changes[--count];
+            if (change->number != 0){
+                cells[change->cell] = 0;
+            }
+        }
+        Mask candidates = frame->candidates;
+        while (candidates != 0){
+            cells[frame->cell] = mask_first(candidates);
+            checkpoint_add(checkpoint, cells, depth + level + 1);
+            candidates = mask_drop_first(candidates);
+        }
+        cells[frame->cell] = 0;
+    }
+    free(cells);
+}
+
+/**
+ * Adds subproblems received as wire messages back to back.
+ *
+ * @param checkpoint Checkpoint to add to.
+ * @param items Wire messages of the subproblems.
+ * @param size Bytes of the messages.
+ * @return Returns zero if a message is not one of a board of the given puzzle, nothing is added then.
+ */
+int checkpoint_append(Checkpoint * checkpoint, uint8_t * items, size_t size){
+    int count = 0, n = checkpoint->given->n;
+    uint8_t * cells = malloc(n * n);
+    size_t offset = 0, bytes;
+    while (offset < size){
+        bytes = wire_size(items + offset, size - offset);
+        if (bytes == 0 || !wire_decode(items + offset, bytes, checkpoint->given, cells, NULL)){
+            free(cells);
+            return 0;
+        }
+        offset += bytes;
+        count++;
+    }
+    free(cells);
+
+    reserve(checkpoint, size);
+    memcpy(checkpoint->items + checkpoint->size, items, size);
+    checkpoint->size += size;
+    checkpoint->count += count;
+    return 1;
+}
+
+/**
+ * Reads the subproblem at an offset and moves the offset to the next one.
+ *
+ * @param checkpoint Checkpoint to read.
+ * @param offset Offset of the subproblem, 0 for the first one.
+ * @param cells Cells to fill, same size as the given puzzle.
+ * @param depth Set to the decisions taken from the given puzzle.
+ * @return Returns zero once every subproblem was read.
+ */
+int checkpoint_next(Checkpoint * checkpoint, size_t * offset, uint8_t * cells, int * depth){
+    if (*offset >= checkpoint->size){
+        return 0;
+    }
+    size_t bytes = wire_size(checkpoint->items + *offset, checkpoint->size - *offset);
+    wire_decode(checkpoint->items + *offset, bytes, checkpoint->given, cells, depth);
+    *offset += bytes;
+    return 1;
+}
+
+/**
+ * Writes a checkpoint to a file. It is written to a temporary file next to
+ * it first and renamed over it once on disk, so a process killed while
+ * writing leaves the previous checkpoint whole.
+ *
+ * @param checkpoint Checkpoint to write.
+ * @param path Path of the checkpoint file.
+ * @return Returns zero if the file could not be written.
+ */
+int checkpoint_write(Checkpoint * checkpoint, char * path){
+    size_t length = strlen(path);
+    char * temporary = malloc(length + 5);
+    memcpy(temporary, path, length);
+    strcpy(temporary + length, ".tmp");
+
+    CheckpointHeader header;
+    memcpy(header.magic, CHECKPOINT_MAGIC, 4);
+    header.version = CHECKPOINT_VERSION;
+    header.root_n = checkpoint->given->root_n;
+    header.reserved = 0;
+    header.count = checkpoint->count;
+    header.size = checkpoint->size;
+    int n = checkpoint->given->n;
+
+    FILE * file = fopen(temporary, "wb");
+    int written = file != NULL &&
+                  fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(checkpoint->given->cells, n * n, 1, file) == 1 &&
+                  (checkpoint->size == 0 || fwrite(checkpoint->items, checkpoint->size, 1, file) == 1) &&
+                  fflush(file) == 0 && fsync(fileno(file)) == 0;
+    if (file != NULL && fclose(file) != 0){
+        written = 0;
+    }
+    written = written && rename(temporary, path) == 0;
+    if (!written){
+        remove(temporary);
+    }
+    free(temporary);
+    return written;
+}
+
+/**
+ * Reads the subproblems of a checkpoint file into a checkpoint of the same
+ * puzzle, after the ones it already holds.
+ *
+ * @param checkpoint Checkpoint to read into.
+ * @param path Path of the checkpoint file.
+ * @return Returns CHECKPOINT_READ, CHECKPOINT_MISSING if there is no file or CHECKPOINT_INVALID if it is not a checkpoint of the puzzle.
+ */
+int checkpoint_read(Checkpoint * checkpoint, char * path){
+    FILE * file = fopen(path, "rb");
+    if (file == NULL){
+        return CHECKPOINT_MISSING;
+    }
+
+    CheckpointHeader header;
+    int n = checkpoint->given->n;
+    int valid = fread(&header, sizeof(header), 1, file) == 1 &&
+                memcmp(header.magic, CHECKPOINT_MAGIC, 4) == 0 &&
+                header.version == CHECKPOINT_VERSION &&
+                header.root_n == checkpoint->given->root_n;
+    uint8_t * buffer = NULL;
+    if (valid){
+        buffer = malloc(n * n > header.size ? (size_t) n * n : header.size);
+        valid = fread(buffer, n * n, 1, file) == 1 &&
+                memcmp(buffer, checkpoint->given->cells, n * n) == 0 &&
+                (header.size == 0 || fread(buffer, header.size, 1, file) == 1) &&
+                fgetc(file) == EOF;
+    }
+    if (valid){
+        int count = checkpoint->count;
+        valid = checkpoint_append(checkpoint, buffer, header.size) &&
+                checkpoint->count - count == (int) header.count;
+    }
+    free(buffer);
+    fclose(file);
+    return valid ? CHECKPOINT_READ : CHECKPOINT_INVALID;
+}
+
+/**
+ * Free's a checkpoint.
+ *
+ * @param checkpoint Checkpoint to free.
+ */
+void checkpoint_free(Checkpoint * checkpoint){
+    if (checkpoint != NULL) {
+        board_free(checkpoint->given);
+        free(checkpoint->items);
+        free(checkpoint);
+    }
+}
+
+/**
+ * Starts the limit of the branches handed to the kernel.
+ *
+ * @param leaf Limit to start.
+ * @param cutoff Empty cells of the first limit, --cutoff or the board width.
+ * @param interval Seconds between two checkpoints.
+ */
+void checkpoint_leaf_init(LeafCutoff * leaf, int cutoff, int interval){
+    leaf->cutoff = cutoff;
+    leaf->leaves = 0;
+    leaf->seen = 0;
+    leaf->solved = 0;
+    leaf->share = (double) interval / LEAF_SHARE;
+}
+
+/**
+ * Spawn hook body of a search while checkpoints are written: a branch
+ * leaving few enough empty cells is searched whole by the kernel, which
+ * copies the solution out if it finds one. The limit moves by one level
+ * of the search after every branch, up while they take less than half of
+ * a LEAF_SHARE of the checkpoint interval and down while they take more
+ * than twice as much. The size of a subtree is only a guess, so a branch
+ * still running after LEAF_GIVE_UP shares is given back to the search,
+ * which splits it further, and the limit drops to half its empty cells
+ * rather than let such branches hold back the checkpoint.
+ *
+ * @param leaf Limit of the worker.
+ * @param search Search trying the branch.
+ * @param cell Cell of the branch.
+ * @param number Number of the branch.
+ * @param solution Cells the solution is copied to.
+ * @param options Options of the solver.
+ * @param stats Counters of the worker.
+ * @param stop Stop hook of the kernel, or NULL; no branch is searched once it returns non-zero.
+ * @param data Argument of the stop hook.
+ * @return Returns non-zero if the branch was taken out of the search.
+ */
+int checkpoint_leaf_solve(LeafCutoff * leaf, Search * search, int cell, int number, uint8_t * solution,
+                          Options * options, Stats * stats, int (*stop)(void * data), void * data){
+    Constraints * constraints = search->constraints;
+    int open = search->stack[search->depth - 1].open;
+    if (!options->kernel || !kernel_supported(constraints->root_n) || open - 1 > leaf->cutoff){
+        return 0;
+    }
+    // the rest of the slice is skipped once the search is over
+    if (leaf->solved || (stop != NULL && stop(data))){
+        return 1;
+    }
+
+    uint8_t values[MAX_MASK_CELLS];
+    int size = constraints->n * constraints->n;
+    double start = wall_time();
+    leaf->leaves++;
+    memcpy(values, constraints->values, size);
+    values[cell] = number;
+    LeafStop limit = {stop, data, start + leaf->share * LEAF_GIVE_UP, 0};
+    if (kernel_solve(constraints->root_n, values, options, stats, leaf_stop, &limit)){
+        memcpy(solution, values, size);
+        leaf->solved = 1;
+    } else if (limit.expired){
+        // far too large a guess, the limit starts again from half the cells and climbs back
+        leaf->cutoff = leaf->cutoff < open / 2 ? leaf->cutoff : open / 2;
+        return 0;
+    }
+
+    // one level of the search up while the branches are quick, one down while they are slow
+    double took = wall_time() - start;
+    if (took < leaf->share / 2){
+        int above = search->depth > 1 ? search->stack[search->depth - 2].open - 1 : open;
+        leaf->cutoff = leaf->cutoff > above ? leaf->cutoff : above;
+    } else if (took > leaf->share * 2){
+        leaf->cutoff = leaf->cutoff < open - 2 ? leaf->cutoff : open - 2;
+    }
+    return 1;
+}
+
+/**
+ * Called as a search starts, before its first slice.
+ *
+ * @param leaf Limit of the worker.
+ */
+void checkpoint_leaf_start(LeafCutoff * leaf){
+    leaf->solved = 0;
+    leaf->seen = leaf->leaves;
+}
+
+/**
+ * Called after every slice of a search: if the slice handed no branch to
+ * the kernel the search does not reach it yet, and the limit rises to the
+ * branches of the current level.
+ *
+ * @param leaf Limit of the worker.
+ * @param search Suspended search.
+ */
+void checkpoint_leaf_slice(LeafCutoff * leaf, Search * search){
+    if (leaf->leaves == leaf->seen && search->depth > 0 && leaf->cutoff < search->stack[search->depth - 1].open - 1){
+        leaf->cutoff = search->stack[search->depth - 1].open - 1;
+    }
+    leaf->seen = leaf->leaves;
+}
+
+/**
+ * Grows the buffer of the subproblems to hold some more bytes.
+ *
+ * @param checkpoint Checkpoint to grow.
+ * @param size Bytes about to be added.
+ */
+static void reserve(Checkpoint * checkpoint, size_t size){
+    if (checkpoint->size + size <= checkpoint->capacity){
+        return;
+    }
+    while (checkpoint->size + size > checkpoint->capacity){
+        checkpoint->capacity = checkpoint->capacity > 0 ? checkpoint->capacity * 2 : 4096;
+    }
+    checkpoint->items = realloc(checkpoint->items, checkpoint->capacity);
+}
+
+/**
+ * Current time of a monotonic clock.
+ *
+ * @return Returns the time in seconds.
+ */
+static double wall_time(){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/**
+ * Stop hook of a branch searched by the kernel.
+ *
+ * @param data Limit of the branch.
+ * @return Returns non-zero once the worker stops or the branch ran out of time.
+ */
+static int leaf_stop(void * data){
+    LeafStop * limit = data;
+    if (limit->stop != NULL && limit->stop(limit->data)){
+        return 1;
+    }
+    limit->expired = wall_time() > limit->deadline;
+    return limit->expired;
+}
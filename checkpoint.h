@@ -0,0 +1,84 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stddef.h>
+
+#include "board.h"
+#include "options.h"
+#include "search.h"
+#include "stats.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// results of reading a checkpoint file
+#define CHECKPOINT_READ 1
+#define CHECKPOINT_MISSING 0
+#define CHECKPOINT_INVALID -1
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Open subproblems of a search, saved so the search can go on after the
+ * process is gone. Each one is the given puzzle with some cells filled,
+ * and together they cover everything left to search. They are kept as wire
+ * messages back to back, usually the few cells filled since the puzzle.
+ */
+struct Checkpoint {
+    // puzzle as read from its file, a checkpoint of another one is refused
+    Board * given;
+    int count;
+    size_t size;
+    size_t capacity;
+    uint8_t * items;
+};
+
+typedef struct Checkpoint Checkpoint;
+
+/**
+ * Limit of the branches a search hands whole to the kernel while
+ * checkpoints are written. The kernel can not stop for a checkpoint, so
+ * its branches are kept small enough that one is never late, and large
+ * enough that the kernel still does nearly all the search.
+ */
+struct LeafCutoff {
+    // empty cells at or below which a branch goes to the kernel
+    int cutoff;
+    // branches handed so far, and when the search started or its last slice ended
+    long leaves;
+    long seen;
+    // set once the kernel solved a branch, until it is cleared
+    int solved;
+    // seconds a branch is sized to take
+    double share;
+};
+
+typedef struct LeafCutoff LeafCutoff;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Checkpoint * checkpoint_create(Board * given);
+void checkpoint_clear(Checkpoint * checkpoint);
+void checkpoint_add(Checkpoint * checkpoint, uint8_t * cells, int depth);
+void checkpoint_add_search(Checkpoint * checkpoint, Search * search, int depth);
+int checkpoint_append(Checkpoint * checkpoint, uint8_t * items, size_t size);
+int checkpoint_next(Checkpoint * checkpoint, size_t * offset, uint8_t * cells, int * depth);
+int checkpoint_write(Checkpoint * checkpoint, char * path);
+int checkpoint_read(Checkpoint * checkpoint, char * path);
+void checkpoint_free(Checkpoint * checkpoint);
+void checkpoint_leaf_init(LeafCutoff * leaf, int cutoff, int interval);
+int checkpoint_leaf_solve(LeafCutoff * leaf, Search * search, int cell, int number, uint8_t * solution,
+                          Options * options, Stats * stats, int (*stop)(void * data), void * data);
+void checkpoint_leaf_start(LeafCutoff * leaf);
+void checkpoint_leaf_slice(LeafCutoff * leaf, Search * search);
+
+#endif
@@ -0,0 +1,521 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "constraints.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// kinds of unit of a puzzle
+#define UNIT_ROW 0
+#define UNIT_COLUMN 1
+#define UNIT_GRID 2
+
+// initial number of changes a trail can hold
+#define TRAIL_CAPACITY 256
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static void trail_push(Trail * trail, int cell, int number, Mask eliminated);
+static int unit_cell(Constraints * constraints, int kind, int unit, int k);
+static Mask unit_used(Constraints * constraints, int kind, int unit);
+static int eliminate(Constraints * constraints, Trail * trail, int row, int column, Mask digits);
+static int naked_singles(Constraints * constraints, Trail * trail);
+static int hidden_singles(Constraints * constraints, Trail * trail);
+static int locked_candidates(Constraints * constraints, Trail * trail);
+
+
+/**
+ * Check if the digits of a board fit in a single mask.
+ *
+ * @param n Number of rows and columns of the puzzle.
+ * @return Returns non-zero if the constraint state can represent the board.
+ */
+int constraints_supported(int n){
+    return n > 0 && n <= MAX_MASK_DIGITS;
+}
+
+/**
+ * Initializes an empty constraint state. Only the part of the arrays the
+ * board uses is written, the state is sized for the widest board.
+ *
+ * @param constraints Constraint state to initialize.
+ * @param root_n Square root of the number of rows and columns.
+ */
+void constraints_init(Constraints * constraints, int root_n){
+    int n = root_n * root_n;
+    constraints->root_n = root_n;
+    constraints->n = n;
+    constraints->full = mask_full(n);
+    memset(constraints->rows, 0, n * sizeof(Mask));
+    memset(constraints->columns, 0, n * sizeof(Mask));
+    memset(constraints->grids, 0, n * sizeof(Mask));
+    memset(constraints->eliminated, 0, n * n * sizeof(Mask));
+    memset(constraints->values, 0, n * n);
+
+    // every cell starts empty
+    int i;
+    for (i = 0; i < constraints->n; ++i){
+        constraints->row_open[i] = constraints->n;
+        constraints->column_open[i] = constraints->n;
+        constraints->grid_open[i] = constraints->n;
+    }
+    constraints->open_count = constraints->n * constraints->n;
+    for (i = 0; i < constraints->open_count; ++i){
+        constraints->open[i] = i;
+        constraints->open_index[i] = i;
+    }
+}
+
+/**
+ * Creates a new constraint state based on the one received as argument.
+ *
+ * @param constraints Constraint state to copy.
+ * @return Returns the new constraint state, or NULL if the one received is NULL.
+ */
+Constraints * constraints_copy(Constraints * constraints){
+    if (constraints == NULL) {
+        return NULL;
+    }
+    Constraints * copy = malloc(sizeof(Constraints));
+    constraints_copy_to(copy, constraints);
+    return copy;
+}
+
+/**
+ * Copies a constraint state over another one, only the part of the arrays
+ * its board uses.
+ *
+ * @param copy Constraint state to overwrite.
+ * @param constraints Constraint state to copy.
+ */
+void constraints_copy_to(Constraints * copy, Constraints * constraints){
+    int n = constraints->n, cells = n * n;
+    copy->root_n = constraints->root_n;
+    copy->n = n;
+    copy->full = constraints->full;
+    memcpy(copy->rows, constraints->rows, n * sizeof(Mask));
+    memcpy(copy->columns, constraints->columns, n * sizeof(Mask));
+    memcpy(copy->grids, constraints->grids, n * sizeof(Mask));
+    memcpy(copy->row_open, constraints->row_open, n * sizeof(int));
+    memcpy(copy->column_open, constraints->column_open, n * sizeof(int));
+    memcpy(copy->grid_open, constraints->grid_open, n * sizeof(int));
+    copy->open_count = constraints->open_count;
+    memcpy(copy->open, constraints->open, cells * sizeof(uint16_t));
+    memcpy(copy->open_index, constraints->open_index, cells * sizeof(uint16_t));
+    memcpy(copy->eliminated, constraints->eliminated, cells * sizeof(Mask));
+    memcpy(copy->values, constraints->values, cells);
+}
+
+/**
+ * Selects the empty cell with the fewest candidates (minimum remaining values).
+ * Ties are broken by the number of empty cells sharing its row, column and
+ * sub grid, as placing there constrains more of the puzzle.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @return Returns the index (row * n + column) of the cell, or -1 if the puzzle is complete.
+ */
+int constraints_select_cell(Constraints * constraints){
+    int n = constraints->n;
+    int best = -1, best_count = n + 1, best_degree = -1;
+    int i;
+    for (i = 0; i < constraints->open_count; ++i){
+        int cell = constraints->open[i];
+        int row = cell / n;
+        int column = cell % n;
+        int count = mask_count(constraints_candidates(constraints, row, column));
+        if (count > best_count){
+            continue;
+        }
+
+        int degree = constraints->row_open[row] + constraints->column_open[column] +
+                     constraints->grid_open[constraints_grid(constraints, row, column)];
+        if (count < best_count || degree > best_degree){
+            best = cell;
+            best_count = count;
+            best_degree = degree;
+
+            // a dead end or a forced cell can not be beaten
+            if (count <= 1){
+                break;
+            }
+        }
+    }
+    return best;
+}
+
+/**
+ * Selects the first empty cell in row-major order.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @return Returns the index (row * n + column) of the cell, or -1 if the puzzle is complete.
+ */
+int constraints_first_cell(Constraints * constraints){
+    int cells = constraints->n * constraints->n;
+    int cell;
+    for (cell = 0; cell < cells; ++cell){
+        if (constraints_is_open(constraints, cell)){
+            return cell;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Places a number in an empty cell and records it on the trail.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param trail Trail of the changes made to the constraint state.
+ * @param row Row of the cell.
+ * @param column Column of the cell.
+ * @param number Number to place in the cell.
+ * @return Returns zero if the number is not a candidate of the cell.
+ */
+int constraints_assign(Constraints * constraints, Trail * trail, int row, int column, int number){
+    if (!(constraints_candidates(constraints, row, column) & mask_of(number))){
+        return 0;
+    }
+    constraints_place(constraints, row, column, number);
+    trail_push(trail, row * constraints->n + column, number, 0);
+    return 1;
+}
+
+/**
+ * Deduces forced cells until nothing else can be deduced. Applies naked
+ * singles and hidden singles and, once those stall, locked candidates
+ * (pointing and claiming). Every change is recorded on the trail.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param trail Trail of the changes made to the constraint state.
+ * @return Returns zero if the puzzle was found to have no solution.
+ */
+int constraints_propagate(Constraints * constraints, Trail * trail){
+    for (;;){
+        int progress = naked_singles(constraints, trail);
+        if (progress < 0){
+            return 0;
+        }
+
+        int hidden = hidden_singles(constraints, trail);
+        if (hidden < 0){
+            return 0;
+        }
+        if (progress || hidden){
+            continue;
+        }
+
+        int locked = locked_candidates(constraints, trail);
+        if (locked == 0){
+            return 1;
+        }
+    }
+}
+
+/**
+ * Undoes every change recorded on the trail after a mark.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param trail Trail of the changes made to the constraint state.
+ * @param mark Number of changes on the trail to keep.
+ */
+void constraints_undo(Constraints * constraints, Trail * trail, int mark){
+    while (trail->count > mark){
+        Change * change = &trail->changes[--trail->count];
+        if (change->number != 0){
+            constraints_remove(constraints, change->cell / constraints->n,
+                               change->cell % constraints->n, change->number);
+        } else {
+            constraints->eliminated[change->cell] &= ~change->eliminated;
+        }
+    }
+}
+
+/**
+ * Creates an empty trail.
+ *
+ * @return Returns the new trail.
+ */
+Trail * trail_create(){
+    Trail * trail = malloc(sizeof(Trail));
+    trail->count = 0;
+    trail->capacity = TRAIL_CAPACITY;
+    trail->changes = malloc(trail->capacity * sizeof(Change));
+    return trail;
+}
+
+/**
+ * Free's a trail.
+ *
+ * @param trail Trail to free.
+ */
+void trail_free(Trail * trail){
+    if (trail != NULL) {
+        free(trail->changes);
+        free(trail);
+    }
+}
+
+/**
+ * Records a change on a trail, growing it when full.
+ *
+ * @param trail Trail of the changes made to the constraint state.
+ * @param cell Index of the changed cell.
+ * @param number Number placed in the cell, or zero for an elimination.
+ * @param eliminated Digits eliminated from the cell.
+ */
+static void trail_push(Trail * trail, int cell, int number, Mask eliminated){
+    if (trail->count == trail->capacity){
+        trail->capacity *= 2;
+        trail->changes = realloc(trail->changes, trail->capacity * sizeof(Change));
+    }
+    Change * change = &trail->changes[trail->count++];
+    change->cell = cell;
+    change->number = number;
+    change->eliminated = eliminated;
+}
+
+/**
+ * Index of the k-th cell of a row, column or sub grid.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param kind Kind of the unit.
+ * @param unit Index of the unit.
+ * @param k Position of the cell inside the unit.
+ * @return Returns the index of the cell, row * n + column.
+ */
+static int unit_cell(Constraints * constraints, int kind, int unit, int k){
+    int n = constraints->n;
+    int root_n = constraints->root_n;
+    if (kind == UNIT_ROW){
+        return unit * n + k;
+    } else if (kind == UNIT_COLUMN){
+        return k * n + unit;
+    }
+    return ((unit / root_n) * root_n + k / root_n) * n + (unit % root_n) * root_n + k % root_n;
+}
+
+/**
+ * Digits already placed on a row, column or sub grid.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param kind Kind of the unit.
+ * @param unit Index of the unit.
+ * @return Returns the mask of the used digits.
+ */
+static Mask unit_used(Constraints * constraints, int kind, int unit){
+    if (kind == UNIT_ROW){
+        return constraints->rows[unit];
+    } else if (kind == UNIT_COLUMN){
+        return constraints->columns[unit];
+    }
+    return constraints->grids[unit];
+}
+
+/**
+ * Rules digits out of an empty cell, recording the change on the trail.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param trail Trail of the changes made to the constraint state.
+ * @param row Row of the cell.
+ * @param column Column of the cell.
+ * @param digits Digits to rule out.
+ * @return Returns non-zero if any candidate of the cell was removed.
+ */
+static int eliminate(Constraints * constraints, Trail * trail, int row, int column, Mask digits){
+    int cell = row * constraints->n + column;
+    if (!constraints_is_open(constraints, cell)){
+        return 0;
+    }
+    Mask removed = constraints_candidates(constraints, row, column) & digits;
+    if (!removed){
+        return 0;
+    }
+    constraints->eliminated[cell] |= removed;
+    trail_push(trail, cell, 0, removed);
+    return 1;
+}
+
+/**
+ * Places every empty cell that has a single candidate.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param trail Trail of the changes made to the constraint state.
+ * @return Returns -1 on a cell without candidates, 1 if a cell was placed, 0 otherwise.
+ */
+static int naked_singles(Constraints * constraints, Trail * trail){
+    int n = constraints->n;
+    int progress = 0;
+    int i;
+    // walk backwards, placing a cell only moves already visited cells
+    for (i = constraints->open_count - 1; i >= 0; --i){
+        int cell = constraints->open[i];
+        int row = cell / n;
+        int column = cell % n;
+        Mask candidates = constraints_candidates(constraints, row, column);
+        if (candidates == 0){
+            return -1;
+        }
+        if (mask_drop_first(candidates) == 0){
+            constraints_place(constraints, row, column, mask_first(candidates));
+            trail_push(trail, cell, mask_first(candidates), 0);
+            progress = 1;
+        }
+    }
+    return progress;
+}
+
+/**
+ * Places every digit that has a single possible cell on a row, column or sub grid.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param trail Trail of the changes made to the constraint state.
+ * @return Returns -1 if a digit has no possible cell, 1 if a cell was placed, 0 otherwise.
+ */
+static int hidden_singles(Constraints * constraints, Trail * trail){
+    int n = constraints->n;
+    int progress = 0;
+    int kind, unit, k;
+    for (kind = UNIT_ROW; kind <= UNIT_GRID; ++kind){
+        for (unit = 0; unit < n; ++unit){
+            // digits seen in at least one and in at least two empty cells
+            Mask once = 0, twice = 0;
+            for (k = 0; k < n; ++k){
+                int cell = unit_cell(constraints, kind, unit, k);
+                if (constraints_is_open(constraints, cell)){
+                    Mask candidates = constraints_candidates(constraints, cell / n, cell % n);
+                    twice |= once & candidates;
+                    once |= candidates;
+                }
+            }
+
+            Mask missing = constraints->full & ~unit_used(constraints, kind, unit);
+            if (missing & ~once){
+                return -1;
+            }
+
+            Mask singles = missing & once & ~twice;
+            while (singles){
+                int number = mask_first(singles);
+                int cell = -1;
+                singles = mask_drop_first(singles);
+                for (k = 0; k < n && cell < 0; ++k){
+                    int candidate_cell = unit_cell(constraints, kind, unit, k);
+                    if (constraints_is_open(constraints, candidate_cell) &&
+                        (constraints_candidates(constraints, candidate_cell / n, candidate_cell % n) & mask_of(number))){
+                        cell = candidate_cell;
+                    }
+                }
+                // an earlier single of this unit took the only cell of the digit
+                if (cell < 0){
+                    return -1;
+                }
+                constraints_place(constraints, cell / n, cell % n, number);
+                trail_push(trail, cell, number, 0);
+                progress = 1;
+            }
+        }
+    }
+    return progress;
+}
+
+/**
+ * Applies locked candidates. When the cells of a sub grid that can hold a
+ * digit all lie on one row or column, the digit is ruled out of the rest of
+ * that line (pointing). When the cells of a row or column that can hold a
+ * digit all lie in one sub grid, the digit is ruled out of the rest of that
+ * sub grid (claiming).
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param trail Trail of the changes made to the constraint state.
+ * @return Returns 1 if any candidate was removed, 0 otherwise.
+ */
+static int locked_candidates(Constraints * constraints, Trail * trail){
+    int n = constraints->n;
+    int root_n = constraints->root_n;
+    int progress = 0;
+    int grid, line, k, j, other;
+    // candidates of the empty cells of each row and each column of a segment
+    Mask rows[MAX_MASK_DIGITS], columns[MAX_MASK_DIGITS];
+
+    // pointing, per sub grid
+    for (grid = 0; grid < n; ++grid){
+        int top = (grid / root_n) * root_n;
+        int left = (grid % root_n) * root_n;
+        for (k = 0; k < root_n; ++k){
+            rows[k] = 0;
+            columns[k] = 0;
+        }
+        for (k = 0; k < root_n; ++k){
+            for (j = 0; j < root_n; ++j){
+                if (constraints_is_open(constraints, (top + k) * n + left + j)){
+                    Mask candidates = constraints_candidates(constraints, top + k, left + j);
+                    rows[k] |= candidates;
+                    columns[j] |= candidates;
+                }
+            }
+        }
+        for (k = 0; k < root_n; ++k){
+            Mask row_only = rows[k], column_only = columns[k];
+            for (other = 0; other < root_n; ++other){
+                if (other != k){
+                    row_only &= ~rows[other];
+                    column_only &= ~columns[other];
+                }
+            }
+            for (j = 0; j < n; ++j){
+                if (row_only && (j < left || j >= left + root_n)){
+                    progress |= eliminate(constraints, trail, top + k, j, row_only);
+                }
+                if (column_only && (j < top || j >= top + root_n)){
+                    progress |= eliminate(constraints, trail, j, left + k, column_only);
+                }
+            }
+        }
+    }
+
+    // claiming, per row and per column
+    for (line = 0; line < n; ++line){
+        for (k = 0; k < root_n; ++k){
+            rows[k] = 0;
+            columns[k] = 0;
+            for (j = 0; j < root_n; ++j){
+                if (constraints_is_open(constraints, line * n + k * root_n + j)){
+                    rows[k] |= constraints_candidates(constraints, line, k * root_n + j);
+                }
+                if (constraints_is_open(constraints, (k * root_n + j) * n + line)){
+                    columns[k] |= constraints_candidates(constraints, k * root_n + j, line);
+                }
+            }
+        }
+        int band = (line / root_n) * root_n;
+        for (k = 0; k < root_n; ++k){
+            Mask row_only = rows[k], column_only = columns[k];
+            for (other = 0; other < root_n; ++other){
+                if (other != k){
+                    row_only &= ~rows[other];
+                    column_only &= ~columns[other];
+                }
+            }
+            for (other = band; other < band + root_n; ++other){
+                if (other == line){
+                    continue;
+                }
+                for (j = 0; j < root_n; ++j){
+                    if (row_only){
+                        progress |= eliminate(constraints, trail, other, k * root_n + j, row_only);
+                    }
+                    if (column_only){
+                        progress |= eliminate(constraints, trail, k * root_n + j, other, column_only);
+                    }
+                }
+            }
+        }
+    }
+    return progress;
+}
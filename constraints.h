@@ -0,0 +1,194 @@
+#ifndef CONSTRAINTS_H
+#define CONSTRAINTS_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+#include "mask.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// widest board the constraint state holds, root_n up to 9
+#define MAX_MASK_DIGITS 81
+// cells of the widest board the constraint state holds
+#define MAX_MASK_CELLS (MAX_MASK_DIGITS * MAX_MASK_DIGITS)
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Digits already used by every row, column and sub grid of a puzzle.
+ * Updated incrementally as cells are placed and cleared so the candidates
+ * of a cell are a single OR of three masks.
+ *
+ * The empty cells are kept in an unordered set, cells are swapped out when
+ * placed and swapped back when cleared, which must happen in reverse order.
+ *
+ * Propagation may also rule digits out of a cell without placing anything,
+ * those are kept per cell in the eliminated masks.
+ *
+ * The arrays are sized for the widest board, a board of n digits only uses
+ * their first n or n * n entries, and only those are cleared and copied.
+ */
+struct Constraints {
+    int root_n;
+    int n;
+    Mask full;
+    Mask rows[MAX_MASK_DIGITS];
+    Mask columns[MAX_MASK_DIGITS];
+    Mask grids[MAX_MASK_DIGITS];
+    // number of empty cells on every row, column and sub grid
+    int row_open[MAX_MASK_DIGITS];
+    int column_open[MAX_MASK_DIGITS];
+    int grid_open[MAX_MASK_DIGITS];
+    // set of empty cells, indexed row * n + column
+    int open_count;
+    uint16_t open[MAX_MASK_CELLS];
+    uint16_t open_index[MAX_MASK_CELLS];
+    // digits ruled out of each cell by propagation
+    Mask eliminated[MAX_MASK_CELLS];
+    // number placed in each cell, 0 when empty
+    uint8_t values[MAX_MASK_CELLS];
+};
+
+/**
+ * A single undoable change of the constraint state, either a number placed
+ * in a cell or a set of digits eliminated from it.
+ */
+struct Change {
+    int cell;
+    int number;
+    Mask eliminated;
+};
+
+/**
+ * Stack of the changes made to a constraint state, undone in reverse order
+ * to backtrack to an earlier point of the search.
+ */
+struct Trail {
+    int count;
+    int capacity;
+    struct Change * changes;
+};
+
+typedef struct Constraints Constraints;
+typedef struct Change Change;
+typedef struct Trail Trail;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+int constraints_supported(int n);
+void constraints_init(Constraints * constraints, int root_n);
+Constraints * constraints_copy(Constraints * constraints);
+void constraints_copy_to(Constraints * copy, Constraints * constraints);
+int constraints_select_cell(Constraints * constraints);
+int constraints_first_cell(Constraints * constraints);
+int constraints_assign(Constraints * constraints, Trail * trail, int row, int column, int number);
+int constraints_propagate(Constraints * constraints, Trail * trail);
+void constraints_undo(Constraints * constraints, Trail * trail, int mark);
+Trail * trail_create();
+void trail_free(Trail * trail);
+
+
+////////////////////////////////////////////////////////////
+//// Inline Functions
+////////////////////////////////////////////////////////////
+
+/**
+ * Index of the sub grid that contains a cell.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param row Row of the cell.
+ * @param column Column of the cell.
+ * @return Returns the sub grid index, counted row-major.
+ */
+static inline int constraints_grid(Constraints * constraints, int row, int column){
+    return (row / constraints->root_n) * constraints->root_n + column / constraints->root_n;
+}
+
+/**
+ * Digits that can still be placed in a cell.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param row Row of the cell.
+ * @param column Column of the cell.
+ * @return Returns the mask of the legal digits of the cell.
+ */
+static inline Mask constraints_candidates(Constraints * constraints, int row, int column){
+    return constraints->full & ~(constraints->rows[row] |
+                                 constraints->columns[column] |
+                                 constraints->grids[constraints_grid(constraints, row, column)] |
+                                 constraints->eliminated[row * constraints->n + column]);
+}
+
+/**
+ * Check if a cell is still empty.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param cell Index of the cell, row * n + column.
+ * @return Returns non-zero if the cell is in the set of empty cells.
+ */
+static inline int constraints_is_open(Constraints * constraints, int cell){
+    return constraints->open_index[cell] < constraints->open_count;
+}
+
+/**
+ * Marks a digit as used by the row, column and sub grid of a cell.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param row Row of the cell.
+ * @param column Column of the cell.
+ * @param number Digit placed in the cell.
+ */
+static inline void constraints_place(Constraints * constraints, int row, int column, int number){
+    Mask bit = mask_of(number);
+    int grid = constraints_grid(constraints, row, column);
+    constraints->rows[row] |= bit;
+    constraints->columns[column] |= bit;
+    constraints->grids[grid] |= bit;
+    constraints->row_open[row]--;
+    constraints->column_open[column]--;
+    constraints->grid_open[grid]--;
+
+    // swap the cell with the last empty one and shrink the set
+    int cell = row * constraints->n + column;
+    constraints->values[cell] = number;
+    int index = constraints->open_index[cell];
+    int last = constraints->open[--constraints->open_count];
+    constraints->open[index] = last;
+    constraints->open_index[last] = index;
+    constraints->open[constraints->open_count] = cell;
+    constraints->open_index[cell] = constraints->open_count;
+}
+
+/**
+ * Releases a digit from the row, column and sub grid of a cell.
+ *
+ * @param constraints Constraint state of the puzzle.
+ * @param row Row of the cell.
+ * @param column Column of the cell.
+ * @param number Digit removed from the cell.
+ */
+static inline void constraints_remove(Constraints * constraints, int row, int column, int number){
+    Mask bit = ~mask_of(number);
+    int grid = constraints_grid(constraints, row, column);
+    constraints->rows[row] &= bit;
+    constraints->columns[column] &= bit;
+    constraints->grids[grid] &= bit;
+    constraints->row_open[row]++;
+    constraints->column_open[column]++;
+    constraints->grid_open[grid]++;
+
+    // the cell was left right after the set, grow the set back over it
+    constraints->values[row * constraints->n + column] = 0;
+    constraints->open_count++;
+}
+
+#endif
@@ -0,0 +1,278 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlx.h"
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static void cover(Dlx * dlx, int column);
+static void uncover(Dlx * dlx, int column);
+static int choose_column(Dlx * dlx);
+
+
+/**
+ * Builds the exact cover matrix of a puzzle.
+ *
+ * @param root_n Square root of the number of rows and columns.
+ * @param values Cells of the puzzle in row-major order, 0 for an empty cell.
+ * @return Returns the matrix, or NULL if two of the given values conflict.
+ */
+Dlx * dlx_create(int root_n, uint8_t * values){
+    int n = root_n * root_n;
+    int cells = n * n;
+    // the four constraint families: cell, row-digit, column-digit and grid-digit
+    char * used = calloc(4 * cells, sizeof(char));
+    int cell, digit;
+
+    for (cell = 0; cell < cells; ++cell){
+        if (values[cell] == 0){
+            continue;
+        }
+        int r = cell / n, c = cell % n, d = values[cell] - 1;
+        int b = (r / root_n) * root_n + c / root_n;
+        int ids[4] = { cell, cells + r * n + d, 2 * cells + c * n + d, 3 * cells + b * n + d };
+        int k;
+        for (k = 0; k < 4; ++k){
+            if (used[ids[k]]){
+                free(used);
+                return NULL;
+            }
+            used[ids[k]] = 1;
+        }
+    }
+
+    // count the legal rows to size the node arrays
+    int rows = 0;
+    for (cell = 0; cell < cells; ++cell){
+        if (values[cell] != 0){
+            continue;
+        }
+        int r = cell / n, c = cell % n;
+        int b = (r / root_n) * root_n + c / root_n;
+        for (digit = 0; digit < n; ++digit){
+            if (!used[cells + r * n + digit] && !used[2 * cells + c * n + digit] &&
+                !used[3 * cells + b * n + digit]){
+                rows++;
+            }
+        }
+    }
+
+    Dlx * dlx = malloc(sizeof(Dlx));
+    dlx->root_n = root_n;
+    dlx->n = n;
+    dlx->columns = 4 * cells;
+    dlx->nodes = 1 + dlx->columns + 4 * rows;
+    dlx->left = malloc(dlx->nodes * sizeof(int));
+    dlx->right = malloc(dlx->nodes * sizeof(int));
+    dlx->up = malloc(dlx->nodes * sizeof(int));
+    dlx->down = malloc(dlx->nodes * sizeof(int));
+    dlx->column = malloc(dlx->nodes * sizeof(int));
+    dlx->size = calloc(dlx->columns + 1, sizeof(int));
+    dlx->row = malloc(dlx->nodes * sizeof(int));
+    dlx->choices = malloc((cells + 1) * sizeof(int));
+    dlx->states = 0;
+    dlx->backtracks = 0;
+    dlx->stop = NULL;
+    dlx->data = NULL;
+
+    // link the headers of the unsatisfied constraints after the root
+    int i, last = 0;
+    for (i = 1; i <= dlx->columns; ++i){
+        dlx->up[i] = dlx->down[i] = dlx->column[i] = i;
+        dlx->left[i] = dlx->right[i] = i;
+        if (!used[i - 1]){
+            dlx->right[last] = i;
+            dlx->left[i] = last;
+            last = i;
+        }
+    }
+    dlx->right[last] = 0;
+    dlx->left[0] = last;
+
+    // one row of four nodes per legal (cell, digit)
+    int node = dlx->columns + 1;
+    for (cell = 0; cell < cells; ++cell){
+        if (values[cell] != 0){
+            continue;
+        }
+        int r = cell / n, c = cell % n;
+        int b = (r / root_n) * root_n + c / root_n;
+        for (digit = 0; digit < n; ++digit){
+            int ids[4] = { cell, cells + r * n + digit, 2 * cells + c * n + digit, 3 * cells + b * n + digit };
+            if (used[ids[1]] || used[ids[2]] || used[ids[3]]){
+                continue;
+            }
+            int k;
+            for (k = 0; k < 4; ++k){
+                int header = ids[k] + 1;
+                int current = node + k;
+                dlx->column[current] = header;
+                dlx->row[current] = cell * n + digit;
+                dlx->left[current] = node + (k + 3) % 4;
+                dlx->right[current] = node + (k + 1) % 4;
+                dlx->up[current] = dlx->up[header];
+                dlx->down[current] = header;
+                dlx->down[dlx->up[header]] = current;
+                dlx->up[header] = current;
+                dlx->size[header]++;
+            }
+            node += 4;
+        }
+    }
+
+    free(used);
+    return dlx;
+}
+
+/**
+ * Searches an exact cover with Algorithm X, always branching on the column
+ * with the fewest rows. The search uses an explicit stack, so its depth is
+ * bounded by the number of empty cells and not by the call stack.
+ *
+ * @param dlx Exact cover matrix of the puzzle.
+ * @param values Cells of the puzzle in row-major order, filled with the solution when found.
+ * @return Returns non-zero if the puzzle has a solution, zero if it has none or the stop hook gave up.
+ */
+int dlx_solve(Dlx * dlx, uint8_t * values){
+    int level = 0;
+    int advance = 1;
+    int polls = 0;
+    int column, node, other;
+
+    for (;;){
+        if (advance){
+            // every constraint is covered, the choices are a solution
+            if (dlx->right[0] == 0){
+                break;
+            }
+            column = choose_column(dlx);
+            cover(dlx, column);
+            dlx->choices[level] = dlx->down[column];
+        } else {
+            if (level == 0){
+                return 0;
+            }
+            // undo the row chosen at the previous level and move to the next one
+            level--;
+            node = dlx->choices[level];
+            column = dlx->column[node];
+            for (other = dlx->left[node]; other != node; other = dlx->left[other]){
+                uncover(dlx, dlx->column[other]);
+            }
+            dlx->choices[level] = dlx->down[node];
+        }
+
+        node = dlx->choices[level];
+        if (node == column){
+            // no rows left on this column
+            uncover(dlx, column);
+            dlx->backtracks++;
+            advance = 0;
+            continue;
+        }
+
+        dlx->states++;
+        // the matrix is left half covered, it can only be freed
+        if (dlx->stop != NULL && ++polls == DLX_POLL_INTERVAL){
+            polls = 0;
+            if (dlx->stop(dlx->data)){
+                return 0;
+            }
+        }
+        for (other = dlx->right[node]; other != node; other = dlx->right[other]){
+            cover(dlx, dlx->column[other]);
+        }
+        level++;
+        advance = 1;
+    }
+
+    int i;
+    for (i = 0; i < level; ++i){
+        int row = dlx->row[dlx->choices[i]];
+        values[row / dlx->n] = row % dlx->n + 1;
+    }
+    return 1;
+}
+
+/**
+ * Free's an exact cover matrix.
+ *
+ * @param dlx Exact cover matrix to free.
+ */
+void dlx_free(Dlx * dlx){
+    if (dlx != NULL) {
+        free(dlx->left);
+        free(dlx->right);
+        free(dlx->up);
+        free(dlx->down);
+        free(dlx->column);
+        free(dlx->size);
+        free(dlx->row);
+        free(dlx->choices);
+        free(dlx);
+    }
+}
+
+/**
+ * Removes a column from the header list and every row that covers it from
+ * the other columns.
+ *
+ * @param dlx Exact cover matrix.
+ * @param column Header of the column.
+ */
+static void cover(Dlx * dlx, int column){
+    int i, j;
+    dlx->right[dlx->left[column]] = dlx->right[column];
+    dlx->left[dlx->right[column]] = dlx->left[column];
+    for (i = dlx->down[column]; i != column; i = dlx->down[i]){
+        for (j = dlx->right[i]; j != i; j = dlx->right[j]){
+            dlx->down[dlx->up[j]] = dlx->down[j];
+            dlx->up[dlx->down[j]] = dlx->up[j];
+            dlx->size[dlx->column[j]]--;
+        }
+    }
+}
+
+/**
+ * Restores a column removed by cover, in the exact reverse order.
+ *
+ * @param dlx Exact cover matrix.
+ * @param column Header of the column.
+ */
+static void uncover(Dlx * dlx, int column){
+    int i, j;
+    for (i = dlx->up[column]; i != column; i = dlx->up[i]){
+        for (j = dlx->left[i]; j != i; j = dlx->left[j]){
+            dlx->size[dlx->column[j]]++;
+            dlx->down[dlx->up[j]] = j;
+            dlx->up[dlx->down[j]] = j;
+        }
+    }
+    dlx->right[dlx->left[column]] = column;
+    dlx->left[dlx->right[column]] = column;
+}
+
+/**
+ * Selects the uncovered column with the fewest rows.
+ *
+ * @param dlx Exact cover matrix.
+ * @return Returns the header of the column.
+ */
+static int choose_column(Dlx * dlx){
+    int best = dlx->right[0];
+    int column;
+    for (column = dlx->right[best]; column != 0; column = dlx->right[column]){
+        if (dlx->size[column] < dlx->size[best]){
+            best = column;
+            if (dlx->size[best] <= 1){
+                break;
+            }
+        }
+    }
+    return best;
+}
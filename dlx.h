@@ -0,0 +1,62 @@
+#ifndef DLX_H
+#define DLX_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// rows chosen between two calls of the stop hook
+#define DLX_POLL_INTERVAL 64
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Sudoku puzzle encoded as an exact cover problem for Knuth's Dancing Links
+ * (Algorithm X). Every empty cell and every digit missing from a row, column
+ * or sub grid is a column of the matrix, every legal (cell, digit) pair is a
+ * row covering four of them. Nodes are kept in parallel arrays, node 0 is
+ * the root, nodes 1 to columns are the column headers.
+ */
+struct Dlx {
+    int root_n;
+    int n;
+    int columns;
+    int nodes;
+    // links of every node
+    int * left;
+    int * right;
+    int * up;
+    int * down;
+    // column header of every node and number of nodes of every column
+    int * column;
+    int * size;
+    // (cell * n + digit - 1) of the row a node belongs to
+    int * row;
+    // row chosen at every level of the search
+    int * choices;
+    long states;
+    // columns left with no row to try
+    long backtracks;
+    // optional hook called every DLX_POLL_INTERVAL rows chosen, the search gives up once it returns non-zero
+    int (*stop)(void * data);
+    void * data;
+};
+
+typedef struct Dlx Dlx;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Dlx * dlx_create(int root_n, uint8_t * values);
+int dlx_solve(Dlx * dlx, uint8_t * values);
+void dlx_free(Dlx * dlx);
+
+#endif
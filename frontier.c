@@ -0,0 +1,187 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "constraints.h"
+#include "frontier.h"
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static int load(Frontier * frontier, Constraints * constraints, Trail * trail, uint8_t * cells, Options * options);
+static void add(Frontier * frontier, uint8_t * cells, int depth);
+
+
+/**
+ * Expands a puzzle breadth first, one level of decisions at a time, until
+ * there are at least `--frontier` subproblems per worker or the levels
+ * reach `--frontier-depth`. Every level branches on the cell the search
+ * would pick, every branch is propagated, branches left without a candidate
+ * for some cell are dropped and subproblems at or below `--cutoff` empty
+ * cells are carried over without being split. Boards too wide for a
+ * constraint state are left whole.
+ *
+ * @param board Puzzle to expand.
+ * @param options Options of the solver.
+ * @param workers Workers the subproblems are shared between.
+ * @return Returns the subproblems, none if the puzzle has no solution.
+ */
+Frontier * frontier_expand(Board * board, Options * options, int workers){
+    int n = board->n, size = n * n;
+    Frontier * frontier = malloc(sizeof(Frontier));
+    frontier->root_n = board->root_n;
+    frontier->n = n;
+    frontier->count = 0;
+    frontier->capacity = 0;
+    frontier->cells = NULL;
+    frontier->depths = NULL;
+    frontier->solved = 0;
+    frontier->solution = malloc(size);
+
+    if (!constraints_supported(n)){
+        add(frontier, board->cells, 0);
+        return frontier;
+    }
+
+    Constraints * constraints = malloc(sizeof(Constraints));
+    Trail * trail = trail_create();
+    uint8_t * cells = malloc(size);
+    memcpy(cells, board->cells, size);
+    int open = load(frontier, constraints, trail, cells, options);
+    if (open > 0){
+        add(frontier, cells, 0);
+    }
+
+    int target = options->frontier * workers;
+    int cutoff = options->cutoff >= 0 ? options->cutoff : n;
+    int level, split = 1;
+    for (level = 0; level < options->frontier_depth && frontier->count < target && split && !frontier->solved; ++level){
+        // the level is taken out and its branches added back in its place
+        Frontier previous = *frontier;
+        frontier->count = 0;
+        frontier->capacity = 0;
+        frontier->cells = NULL;
+        frontier->depths = NULL;
+        split = 0;
+
+        int item;
+        for (item = 0; item < previous.count && !frontier->solved; ++item){
+            uint8_t * parent = previous.cells + (size_t) item * size;
+            load(frontier, constraints, trail, parent, options);
+            if (constraints->open_count <= cutoff){
+                add(frontier, parent, previous.depths[item]);
+                continue;
+            }
+
+            int cell = options->branching == BRANCH_MRV ? constraints_select_cell(constraints) : constraints_first_cell(constraints);
+            Mask candidates = constraints_candidates(constraints, cell / n, cell % n);
+            int number;
+            split = 1;
+            for (number = 1; number <= n && !frontier->solved; ++number){
+                if (!(candidates & mask_of(number))){
+                    continue;
+                }
+                memcpy(cells, parent, size);
+                cells[cell] = number;
+                if (load(frontier, constraints, trail, cells, options) > 0){
+                    add(frontier, cells, previous.depths[item] + 1);
+                }
+            }
+        }
+        free(previous.cells);
+        free(previous.depths);
+    }
+
+    free(cells);
+    free(constraints);
+    trail_free(trail);
+    if (frontier->solved){
+        frontier->count = 0;
+    }
+    return frontier;
+}
+
+/**
+ * Cells of a subproblem.
+ *
+ * @param frontier Subproblems of the puzzle.
+ * @param item Index of the subproblem.
+ * @return Returns the n * n cells of the subproblem.
+ */
+uint8_t * frontier_cells(Frontier * frontier, int item){
+    return frontier->cells + (size_t) item * frontier->n * frontier->n;
+}
+
+/**
+ * Free's the subproblems of a puzzle.
+ *
+ * @param frontier Subproblems to free.
+ */
+void frontier_free(Frontier * frontier){
+    if (frontier != NULL) {
+        free(frontier->cells);
+        free(frontier->depths);
+        free(frontier->solution);
+        free(frontier);
+    }
+}
+
+/**
+ * Loads the constraint state of some cells and propagates it, leaving the
+ * cells filled by propagation in place. Cells left with no empty cell are
+ * kept as the solution.
+ *
+ * @param frontier Subproblems of the puzzle.
+ * @param constraints Constraint state to load.
+ * @param trail Trail of the propagation.
+ * @param cells Cells to load, updated with the propagated values.
+ * @param options Options of the solver.
+ * @return Returns the number of empty cells left, -1 if two values conflict or a cell has no candidate.
+ */
+static int load(Frontier * frontier, Constraints * constraints, Trail * trail, uint8_t * cells, Options * options){
+    int n = frontier->n, row, column;
+    constraints_init(constraints, frontier->root_n);
+    trail->count = 0;
+    for (row = 0; row < n; ++row){
+        for (column = 0; column < n; ++column){
+            int number = cells[row * n + column];
+            if (number == 0){
+                continue;
+            }
+            if (!(constraints_candidates(constraints, row, column) & mask_of(number))){
+                return -1;
+            }
+            constraints_place(constraints, row, column, number);
+        }
+    }
+    if (options->propagation && !constraints_propagate(constraints, trail)){
+        return -1;
+    }
+    memcpy(cells, constraints->values, n * n);
+    if (constraints->open_count == 0){
+        memcpy(frontier->solution, cells, n * n);
+        frontier->solved = 1;
+    }
+    return constraints->open_count;
+}
+
+/**
+ * Adds a subproblem at the end of the frontier.
+ *
+ * @param frontier Subproblems of the puzzle.
+ * @param cells Cells of the subproblem.
+ * @param depth Decisions taken from the puzzle.
+ */
+static void add(Frontier * frontier, uint8_t * cells, int depth){
+    int size = frontier->n * frontier->n;
+    if (frontier->count == frontier->capacity){
+        frontier->capacity = frontier->capacity > 0 ? frontier->capacity * 2 : 16;
+        frontier->cells = realloc(frontier->cells, (size_t) frontier->capacity * size);
+        frontier->depths = realloc(frontier->depths, frontier->capacity * sizeof(int));
+    }
+    memcpy(frontier->cells + (size_t) frontier->count * size, cells, size);
+    frontier->depths[frontier->count++] = depth;
+}
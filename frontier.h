@@ -0,0 +1,45 @@
+#ifndef FRONTIER_H
+#define FRONTIER_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+#include "board.h"
+#include "options.h"
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Subproblems of a puzzle expanded breadth first, the initial work of the
+ * parallel solvers. Every subproblem is propagated and left with empty
+ * cells; a subproblem solved on the way ends the expansion and is kept as
+ * the solution instead.
+ */
+struct Frontier {
+    int root_n;
+    int n;
+    int count;
+    int capacity;
+    // cells of subproblem i start at i * n * n
+    uint8_t * cells;
+    // decisions taken from the puzzle to reach every subproblem
+    int * depths;
+    int solved;
+    uint8_t * solution;
+};
+
+typedef struct Frontier Frontier;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Frontier * frontier_expand(Board * board, Options * options, int workers);
+uint8_t * frontier_cells(Frontier * frontier, int item);
+void frontier_free(Frontier * frontier);
+
+#endif
@@ -0,0 +1,232 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernel.h"
+#include "mask.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// initial number of decisions a kernel stack can hold
+#define KERNEL_CAPACITY 64
+// states a kernel searches between two calls of its stop hook
+#define KERNEL_POLL_INTERVAL 16
+
+// bytes of the vectors the candidate sweeps work on
+#define KERNEL_VECTOR_BYTES 32
+
+// instruction sets a candidate sweep can be compiled for
+#define KERNEL_ISA_BASELINE 0
+#define KERNEL_ISA_AVX2 1
+#if defined(__x86_64__) || defined(__i386__)
+#define KERNEL_AVX2
+#endif
+
+#define KERNEL_PASTE(name, root) KERNEL_PASTE_ROOT(name, root)
+#define KERNEL_PASTE_ROOT(name, root) name##_##root
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static int kernel_isa();
+static int kernel_reserve(KernelStack * buffers, int capacity, size_t state, size_t frame);
+
+
+////////////////////////////////////////////////////////////
+//// Kernels
+////////////////////////////////////////////////////////////
+// the narrowest mask that holds the n digits of each size
+#define KERNEL_ROOT 2
+#define KERNEL_MASK uint8_t
+#define KERNEL_FIRST(mask) (__builtin_ctzll(mask) + 1)
+#include "kernel_template.h"
+#undef KERNEL_ROOT
+#undef KERNEL_MASK
+#undef KERNEL_FIRST
+
+#define KERNEL_ROOT 3
+#define KERNEL_MASK uint16_t
+#define KERNEL_FIRST(mask) (__builtin_ctzll(mask) + 1)
+#include "kernel_template.h"
+#undef KERNEL_ROOT
+#undef KERNEL_MASK
+#undef KERNEL_FIRST
+
+#define KERNEL_ROOT 4
+#define KERNEL_MASK uint16_t
+#define KERNEL_FIRST(mask) (__builtin_ctzll(mask) + 1)
+#include "kernel_template.h"
+#undef KERNEL_ROOT
+#undef KERNEL_MASK
+#undef KERNEL_FIRST
+
+#define KERNEL_ROOT 5
+#define KERNEL_MASK uint32_t
+#define KERNEL_FIRST(mask) (__builtin_ctzll(mask) + 1)
+#include "kernel_template.h"
+#undef KERNEL_ROOT
+#undef KERNEL_MASK
+#undef KERNEL_FIRST
+
+#define KERNEL_ROOT 6
+#define KERNEL_MASK uint64_t
+#define KERNEL_FIRST(mask) (__builtin_ctzll(mask) + 1)
+#include "kernel_template.h"
+#undef KERNEL_ROOT
+#undef KERNEL_MASK
+#undef KERNEL_FIRST
+
+#define KERNEL_ROOT 7
+#define KERNEL_MASK uint64_t
+#define KERNEL_FIRST(mask) (__builtin_ctzll(mask) + 1)
+#include "kernel_template.h"
+#undef KERNEL_ROOT
+#undef KERNEL_MASK
+#undef KERNEL_FIRST
+
+#define KERNEL_ROOT 8
+#define KERNEL_MASK uint64_t
+#define KERNEL_FIRST(mask) (__builtin_ctzll(mask) + 1)
+#include "kernel_template.h"
+#undef KERNEL_ROOT
+#undef KERNEL_MASK
+#undef KERNEL_FIRST
+
+// 81 digits take the two words of a multi-word mask
+#define KERNEL_ROOT 9
+#define KERNEL_MASK Mask
+#define KERNEL_FIRST mask_first
+#define KERNEL_COUNT mask_count
+#define KERNEL_SCALAR
+#include "kernel_template.h"
+#undef KERNEL_ROOT
+#undef KERNEL_MASK
+#undef KERNEL_FIRST
+#undef KERNEL_COUNT
+#undef KERNEL_SCALAR
+
+
+////////////////////////////////////////////////////////////
+//// Global Variables
+////////////////////////////////////////////////////////////
+// kernel of each square root of n
+static int (* const _kernels_[KERNEL_MAX_ROOT + 1])(KernelStack *, uint8_t *, int, int, int, Stats *, int (*)(void *), void *) = {
+    NULL, NULL, kernel_solve_2, kernel_solve_3, kernel_solve_4,
+    kernel_solve_5, kernel_solve_6, kernel_solve_7, kernel_solve_8, kernel_solve_9
+};
+
+
+/**
+ * Check if a board size has a specialized kernel.
+ *
+ * @param root_n Square root of the number of rows and columns.
+ * @return Returns non-zero if kernel_solve can solve boards of this size.
+ */
+int kernel_supported(int root_n){
+    return root_n >= KERNEL_MIN_ROOT && root_n <= KERNEL_MAX_ROOT;
+}
+
+/**
+ * Solves a board with the kernel specialized for its size. The numbers
+ * placed must not conflict with each other.
+ *
+ * @param root_n Square root of the number of rows and columns, must be supported.
+ * @param values Numbers of the board, row-major with 0 for empty cells; holds the solution if one is found.
+ * @param options Branching and propagation options.
+ * @param stats Counters of the worker, the states searched, backtracks and cells propagated are added.
+ * @param stop Called every few states with data, or NULL; the search gives up once it returns non-zero.
+ * @param data Argument of the stop hook.
+ * @return Returns non-zero if the board has a solution, zero if it has none or the search gave up.
+ */
+int kernel_solve(int root_n, uint8_t * values, Options * options, Stats * stats, int (*stop)(void * data), void * data){
+    return _kernels_[root_n](NULL, values, options->branching, options->propagation, kernel_isa(), stats, stop, data);
+}
+
+/**
+ * Solves a board like kernel_solve, on stacks kept from one call to the
+ * next.
+ *
+ * @param buffers Stacks of the search, from kernel_stack_create.
+ * @param root_n Square root of the number of rows and columns, must be supported.
+ * @param values Numbers of the board, row-major with 0 for empty cells; holds the solution if one is found.
+ * @param options Branching and propagation options.
+ * @param stats Counters of the worker, the states searched, backtracks and cells propagated are added.
+ * @param stop Called every few states with data, or NULL; the search gives up once it returns non-zero.
+ * @param data Argument of the stop hook.
+ * @return Returns non-zero if the board has a solution, zero if it has none or the search gave up.
+ */
+int kernel_solve_on(KernelStack * buffers, int root_n, uint8_t * values, Options * options, Stats * stats,
+                    int (*stop)(void * data), void * data){
+    return _kernels_[root_n](buffers, values, options->branching, options->propagation, kernel_isa(), stats, stop, data);
+}
+
+/**
+ * Creates empty stacks for kernel_solve_on, allocated by its first call.
+ *
+ * @return Returns the new stacks.
+ */
+KernelStack * kernel_stack_create(){
+    KernelStack * buffers = malloc(sizeof(KernelStack));
+    buffers->states = NULL;
+    buffers->frames = NULL;
+    buffers->state_bytes = 0;
+    buffers->frame_bytes = 0;
+    return buffers;
+}
+
+/**
+ * Free's the stacks of a kernel search.
+ *
+ * @param buffers Stacks to free.
+ */
+void kernel_stack_free(KernelStack * buffers){
+    if (buffers != NULL) {
+        free(buffers->states);
+        free(buffers->frames);
+        free(buffers);
+    }
+}
+
+/**
+ * Selects the instruction set of the candidate sweeps, AVX2 when the
+ * processor supports it and the baseline of the build otherwise (SSE2 on
+ * x86-64).
+ *
+ * @return Returns KERNEL_ISA_AVX2 or KERNEL_ISA_BASELINE.
+ */
+static int kernel_isa(){
+#ifdef KERNEL_AVX2
+    if (__builtin_cpu_supports("avx2")){
+        return KERNEL_ISA_AVX2;
+    }
+#endif
+    return KERNEL_ISA_BASELINE;
+}
+
+/**
+ * Grows the stacks of a kernel search to hold some decisions, keeping what
+ * they hold.
+ *
+ * @param buffers Stacks of the search.
+ * @param capacity Decisions the stacks must hold at least.
+ * @param state Bytes of a state of the kernel.
+ * @param frame Bytes of a decision of the kernel.
+ * @return Returns the decisions the stacks hold.
+ */
+static int kernel_reserve(KernelStack * buffers, int capacity, size_t state, size_t frame){
+    if (buffers->state_bytes < capacity * state){
+        buffers->state_bytes = capacity * state;
+        buffers->states = realloc(buffers->states, buffers->state_bytes);
+    }
+    if (buffers->frame_bytes < capacity * frame){
+        buffers->frame_bytes = capacity * frame;
+        buffers->frames = realloc(buffers->frames, buffers->frame_bytes);
+    }
+    size_t states = buffers->state_bytes / state, frames = buffers->frame_bytes / frame;
+    return states < frames ? states : frames;
+}
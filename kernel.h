@@ -0,0 +1,50 @@
+#ifndef KERNEL_H
+#define KERNEL_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stddef.h>
+
+#include "options.h"
+#include "stats.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// range of square roots of n with a specialized kernel
+#define KERNEL_MIN_ROOT 2
+#define KERNEL_MAX_ROOT 9
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Stacks of the states and decisions of a kernel search, kept by a worker
+ * that solves many boards so they are allocated once rather than on every
+ * call. They grow to the deepest search and the largest board solved.
+ */
+struct KernelStack {
+    void * states;
+    void * frames;
+    size_t state_bytes;
+    size_t frame_bytes;
+};
+
+typedef struct KernelStack KernelStack;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+int kernel_supported(int root_n);
+int kernel_solve(int root_n, uint8_t * values, Options * options, Stats * stats, int (*stop)(void * data), void * data);
+int kernel_solve_on(KernelStack * buffers, int root_n, uint8_t * values, Options * options, Stats * stats,
+                    int (*stop)(void * data), void * data);
+KernelStack * kernel_stack_create();
+void kernel_stack_free(KernelStack * buffers);
+
+#endif
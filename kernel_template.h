@@ -0,0 +1,623 @@
+/**
+ * Body of a solver kernel specialized for a single board size, included once
+ * per size by kernel.c after defining:
+ *
+ * KERNEL_ROOT square root of the number of rows and columns,
+ * KERNEL_MASK unsigned type with at least KERNEL_ROOT^2 bits,
+ * KERNEL_FIRST lowest digit of a non-empty KERNEL_MASK,
+ * KERNEL_SCALAR when KERNEL_MASK is too wide for a vector lane, with
+ * KERNEL_COUNT the number of digits of a KERNEL_MASK.
+ *
+ * Every bound is a constant, so the unit loops are unrolled and the cell
+ * divisions folded by the compiler. The candidates of whole rows are
+ * computed at once on vectors of masks, or a cell at a time for the
+ * scalar kernels. The state is small enough that the
+ * search copies it on every decision instead of keeping a trail. The
+ * deductions and the branching follow the generic constraint state.
+ */
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+#define K_N (KERNEL_ROOT * KERNEL_ROOT)
+#define K_CELLS (K_N * K_N)
+#define K_FULL ((KERNEL_MASK) ((KERNEL_MASK) ~(KERNEL_MASK) 0 >> (8 * sizeof(KERNEL_MASK) - K_N)))
+#define K_BIT(number) ((KERNEL_MASK) ((KERNEL_MASK) 1 << ((number) - 1)))
+#define K_GRID(cell) (((cell) / K_N / KERNEL_ROOT) * KERNEL_ROOT + (cell) % K_N / KERNEL_ROOT)
+#define K_NAME(name) KERNEL_PASTE(name, KERNEL_ROOT)
+// masks per vector and a row rounded up to whole vectors
+#ifdef KERNEL_SCALAR
+#define K_LANES 1
+#else
+#define K_LANES (KERNEL_VECTOR_BYTES / (int) sizeof(KERNEL_MASK))
+#endif
+#define K_PAD (((K_N + K_LANES - 1) / K_LANES) * K_LANES)
+// count of a filled cell in a sweep, above any number of candidates
+#define K_FILLED 0xFF
+
+
+#ifndef KERNEL_SCALAR
+////////////////////////////////////////////////////////////
+//// Types
+////////////////////////////////////////////////////////////
+typedef KERNEL_MASK K_NAME(KernelVector) __attribute__((vector_size(KERNEL_VECTOR_BYTES)));
+typedef uint8_t K_NAME(KernelBytes) __attribute__((vector_size(K_LANES)));
+#endif
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Digits used by every unit, the digits ruled out of every cell by
+ * propagation and the number placed in every cell. The arrays read a vector
+ * at a time are padded so the last vector of a row stays in bounds.
+ */
+struct K_NAME(KernelState) {
+    KERNEL_MASK rows[K_N];
+    KERNEL_MASK columns[K_PAD];
+    KERNEL_MASK grids[K_N];
+    KERNEL_MASK eliminated[K_CELLS + K_PAD];
+    // number of empty cells on every row, column and sub grid
+    uint8_t row_open[K_N];
+    uint8_t column_open[K_N];
+    uint8_t grid_open[K_N];
+    uint8_t values[K_CELLS + K_PAD];
+};
+
+/**
+ * A decision of the search, the cell branched on and the numbers still to try.
+ */
+struct K_NAME(KernelFrame) {
+    int cell;
+    KERNEL_MASK candidates;
+};
+
+
+/**
+ * Places a number in a cell.
+ *
+ * @param state State of the board.
+ * @param cell Index of the cell, row * n + column.
+ * @param number Digit placed in the cell.
+ */
+static inline void K_NAME(kernel_place)(struct K_NAME(KernelState) * state, int cell, int number){
+    KERNEL_MASK bit = K_BIT(number);
+    state->rows[cell / K_N] |= bit;
+    state->columns[cell % K_N] |= bit;
+    state->grids[K_GRID(cell)] |= bit;
+    state->row_open[cell / K_N]--;
+    state->column_open[cell % K_N]--;
+    state->grid_open[K_GRID(cell)]--;
+    state->values[cell] = number;
+}
+
+/**
+ * Digits that can still be placed in a cell.
+ *
+ * @param state State of the board.
+ * @param cell Index of the cell, row * n + column.
+ * @return Returns the mask of the legal digits of the cell.
+ */
+static inline KERNEL_MASK K_NAME(kernel_candidates)(struct K_NAME(KernelState) * state, int cell){
+    return K_FULL & ~(state->rows[cell / K_N] | state->columns[cell % K_N] |
+                      state->grids[K_GRID(cell)] | state->eliminated[cell]);
+}
+
+/**
+ * Rules digits out of a cell, if it is still empty.
+ *
+ * @param state State of the board.
+ * @param cell Index of the cell, row * n + column.
+ * @param digits Digits to rule out.
+ * @return Returns non-zero if any candidate of the cell was removed.
+ */
+static inline int K_NAME(kernel_eliminate)(struct K_NAME(KernelState) * state, int cell, KERNEL_MASK digits){
+    if (state->values[cell] != 0 || !(K_NAME(kernel_candidates)(state, cell) & digits)){
+        return 0;
+    }
+    state->eliminated[cell] |= digits;
+    return 1;
+}
+
+#ifdef KERNEL_SCALAR
+/**
+ * Counts the candidates of every cell.
+ *
+ * @param state State of the board.
+ * @param counts Filled with the number of candidates of every cell, K_FILLED for filled cells.
+ * @param isa Unused, the masks are too wide for the vector sweeps.
+ */
+static inline void K_NAME(kernel_sweep)(struct K_NAME(KernelState) * state, uint8_t * counts, int isa){
+    int cell;
+    (void) isa;
+    for (cell = 0; cell < K_CELLS; ++cell){
+        counts[cell] = state->values[cell] != 0 ? K_FILLED : KERNEL_COUNT(K_NAME(kernel_candidates)(state, cell));
+    }
+}
+#else
+/**
+ * Replaces every mask of a vector by its number of digits.
+ *
+ * @param masks Vector of masks.
+ */
+static inline __attribute__((always_inline)) void K_NAME(kernel_popcount)(K_NAME(KernelVector) * masks){
+    K_NAME(KernelVector) bits = *masks;
+    int shift;
+    bits = bits - ((bits >> 1) & (KERNEL_MASK) 0x5555555555555555ULL);
+    bits = (bits & (KERNEL_MASK) 0x3333333333333333ULL) + ((bits >> 2) & (KERNEL_MASK) 0x3333333333333333ULL);
+    bits = (bits + (bits >> 4)) & (KERNEL_MASK) 0x0F0F0F0F0F0F0F0FULL;
+    // add up the bytes of each mask
+    for (shift = 8; shift < 8 * (int) sizeof(KERNEL_MASK); shift *= 2){
+        bits += bits >> shift;
+    }
+    *masks = bits & (KERNEL_MASK) 0xFF;
+}
+
+/**
+ * Counts the candidates of every cell, a vector of cells of a row at a time.
+ *
+ * @param state State of the board.
+ * @param counts Filled with the number of candidates of every cell, K_FILLED for filled cells.
+ */
+static inline __attribute__((always_inline)) void K_NAME(kernel_sweep_body)(struct K_NAME(KernelState) * state, uint8_t * counts){
+    K_NAME(KernelVector) columns, grids, eliminated, candidates, filled;
+    K_NAME(KernelBytes) values, count;
+    // sub grid of every column of the current band of rows
+    KERNEL_MASK band_grids[K_PAD] = {0};
+    int band, row, i, j;
+
+    for (band = 0; band < K_N; band += KERNEL_ROOT){
+        for (i = 0; i < KERNEL_ROOT; ++i){
+            for (j = 0; j < KERNEL_ROOT; ++j){
+                band_grids[i * KERNEL_ROOT + j] = state->grids[band + i];
+            }
+        }
+        for (row = band; row < band + KERNEL_ROOT; ++row){
+            for (i = 0; i < K_N; i += K_LANES){
+                memcpy(&columns, &state->columns[i], sizeof(columns));
+                memcpy(&grids, &band_grids[i], sizeof(grids));
+                memcpy(&eliminated, &state->eliminated[row * K_N + i], sizeof(eliminated));
+                memcpy(&values, &state->values[row * K_N + i], sizeof(values));
+                candidates = K_FULL & ~(state->rows[row] | columns | grids | eliminated);
+                K_NAME(kernel_popcount)(&candidates);
+                filled = (K_NAME(KernelVector)) (__builtin_convertvector(values, K_NAME(KernelVector)) != 0);
+                count = __builtin_convertvector(candidates | filled, K_NAME(KernelBytes));
+                // the lanes past the row are overwritten by the next one
+                memcpy(&counts[row * K_N + i], &count, sizeof(count));
+            }
+        }
+    }
+}
+
+#ifdef KERNEL_AVX2
+__attribute__((target("avx2")))
+static void K_NAME(kernel_sweep_avx2)(struct K_NAME(KernelState) * state, uint8_t * counts){
+    K_NAME(kernel_sweep_body)(state, counts);
+}
+#endif
+
+static void K_NAME(kernel_sweep_baseline)(struct K_NAME(KernelState) * state, uint8_t * counts){
+    K_NAME(kernel_sweep_body)(state, counts);
+}
+
+/**
+ * Counts the candidates of every cell with the widest vectors the processor supports.
+ *
+ * @param state State of the board.
+ * @param counts Filled with the number of candidates of every cell, K_FILLED for filled cells.
+ * @param isa Instruction set selected by kernel_solve.
+ */
+static inline void K_NAME(kernel_sweep)(struct K_NAME(KernelState) * state, uint8_t * counts, int isa){
+#ifdef KERNEL_AVX2
+    if (isa == KERNEL_ISA_AVX2){
+        K_NAME(kernel_sweep_avx2)(state, counts);
+        return;
+    }
+#endif
+    K_NAME(kernel_sweep_baseline)(state, counts);
+}
+#endif
+
+/**
+ * Fills every empty cell that has a single legal digit.
+ *
+ * @param state State of the board.
+ * @param isa Instruction set of the candidate sweep.
+ * @return Returns the number of cells filled, or -1 if a cell has no legal digit.
+ */
+static int K_NAME(kernel_naked_singles)(struct K_NAME(KernelState) * state, int isa){
+    uint8_t counts[K_CELLS + K_PAD];
+    int cell, placed = 0;
+    K_NAME(kernel_sweep)(state, counts, isa);
+    for (cell = 0; cell < K_CELLS; ++cell){
+        if (counts[cell] > 1){
+            continue;
+        }
+        // cells filled earlier in this pass may have taken the last candidate
+        KERNEL_MASK candidates = K_NAME(kernel_candidates)(state, cell);
+        if (candidates == 0){
+            return -1;
+        }
+        if ((candidates & (candidates - 1)) == 0){
+            K_NAME(kernel_place)(state, cell, KERNEL_FIRST(candidates));
+            placed++;
+        }
+    }
+    return placed;
+}
+
+/**
+ * Places every digit that fits a single cell of a unit.
+ *
+ * @param state State of the board.
+ * @param cells The n cells of the unit.
+ * @return Returns the number of cells filled, or -1 if a digit fits no cell of the unit.
+ */
+static int K_NAME(kernel_hidden_unit)(struct K_NAME(KernelState) * state, const int * cells){
+    KERNEL_MASK used = 0, once = 0, twice = 0;
+    int i, placed = 0;
+    for (i = 0; i < K_N; ++i){
+        if (state->values[cells[i]] != 0){
+            used |= K_BIT(state->values[cells[i]]);
+            continue;
+        }
+        KERNEL_MASK candidates = K_NAME(kernel_candidates)(state, cells[i]);
+        twice |= once & candidates;
+        once |= candidates;
+    }
+    if ((used | once) != K_FULL){
+        return -1;
+    }
+
+    KERNEL_MASK singles = once & ~twice;
+    while (singles){
+        int number = KERNEL_FIRST(singles);
+        singles &= singles - 1;
+        // a cell filled by an earlier single of the unit leaves this one nowhere to go
+        for (i = 0; i < K_N; ++i){
+            if (state->values[cells[i]] == 0 && (K_NAME(kernel_candidates)(state, cells[i]) & K_BIT(number))){
+                break;
+            }
+        }
+        if (i == K_N){
+            return -1;
+        }
+        K_NAME(kernel_place)(state, cells[i], number);
+        placed++;
+    }
+    return placed;
+}
+
+/**
+ * Places every digit that fits a single cell of a row, column or sub grid.
+ *
+ * @param state State of the board.
+ * @return Returns the number of cells filled, or -1 if a digit fits no cell of a unit.
+ */
+static int K_NAME(kernel_hidden_singles)(struct K_NAME(KernelState) * state){
+    int cells[K_N];
+    int unit, i, j, result, placed = 0;
+    for (unit = 0; unit < K_N; ++unit){
+        for (i = 0; i < K_N; ++i){
+            cells[i] = unit * K_N + i;
+        }
+        if ((result = K_NAME(kernel_hidden_unit)(state, cells)) < 0){
+            return -1;
+        }
+        placed += result;
+
+        for (i = 0; i < K_N; ++i){
+            cells[i] = i * K_N + unit;
+        }
+        if ((result = K_NAME(kernel_hidden_unit)(state, cells)) < 0){
+            return -1;
+        }
+        placed += result;
+
+        int first = (unit / KERNEL_ROOT) * KERNEL_ROOT * K_N + (unit % KERNEL_ROOT) * KERNEL_ROOT;
+        for (i = 0; i < KERNEL_ROOT; ++i){
+            for (j = 0; j < KERNEL_ROOT; ++j){
+                cells[i * KERNEL_ROOT + j] = first + i * K_N + j;
+            }
+        }
+        if ((result = K_NAME(kernel_hidden_unit)(state, cells)) < 0){
+            return -1;
+        }
+        placed += result;
+    }
+    return placed;
+}
+
+/**
+ * Digits of one segment of a unit that appear in no other segment of it.
+ *
+ * @param segments Candidates of the root_n segments of a unit.
+ * @param k Segment to check.
+ * @return Returns the digits locked to the segment.
+ */
+static inline KERNEL_MASK K_NAME(kernel_locked)(const KERNEL_MASK * segments, int k){
+    KERNEL_MASK only = segments[k];
+    int other;
+    for (other = 0; other < KERNEL_ROOT; ++other){
+        if (other != k){
+            only &= ~segments[other];
+        }
+    }
+    return only;
+}
+
+/**
+ * Applies locked candidates, pointing per sub grid and claiming per row and column.
+ *
+ * @param state State of the board.
+ * @return Returns non-zero if any candidate was removed.
+ */
+static int K_NAME(kernel_locked_candidates)(struct K_NAME(KernelState) * state){
+    KERNEL_MASK rows[KERNEL_ROOT], columns[KERNEL_ROOT];
+    int grid, line, k, j, other, progress = 0;
+
+    // pointing, the digits of a sub grid confined to one of its rows or columns
+    for (grid = 0; grid < K_N; ++grid){
+        int top = (grid / KERNEL_ROOT) * KERNEL_ROOT;
+        int left = (grid % KERNEL_ROOT) * KERNEL_ROOT;
+        for (k = 0; k < KERNEL_ROOT; ++k){
+            rows[k] = 0;
+            columns[k] = 0;
+        }
+        for (k = 0; k < KERNEL_ROOT; ++k){
+            for (j = 0; j < KERNEL_ROOT; ++j){
+                int cell = (top + k) * K_N + left + j;
+                if (state->values[cell] == 0){
+                    KERNEL_MASK candidates = K_NAME(kernel_candidates)(state, cell);
+                    rows[k] |= candidates;
+                    columns[j] |= candidates;
+                }
+            }
+        }
+        for (k = 0; k < KERNEL_ROOT; ++k){
+            KERNEL_MASK row_only = K_NAME(kernel_locked)(rows, k);
+            KERNEL_MASK column_only = K_NAME(kernel_locked)(columns, k);
+            for (j = 0; j < K_N; ++j){
+                if (row_only && (j < left || j >= left + KERNEL_ROOT)){
+                    progress |= K_NAME(kernel_eliminate)(state, (top + k) * K_N + j, row_only);
+                }
+                if (column_only && (j < top || j >= top + KERNEL_ROOT)){
+                    progress |= K_NAME(kernel_eliminate)(state, j * K_N + left + k, column_only);
+                }
+            }
+        }
+    }
+
+    // claiming, the digits of a row or column confined to one sub grid
+    for (line = 0; line < K_N; ++line){
+        for (k = 0; k < KERNEL_ROOT; ++k){
+            rows[k] = 0;
+            columns[k] = 0;
+            for (j = 0; j < KERNEL_ROOT; ++j){
+                int cell = line * K_N + k * KERNEL_ROOT + j;
+                if (state->values[cell] == 0){
+                    rows[k] |= K_NAME(kernel_candidates)(state, cell);
+                }
+                cell = (k * KERNEL_ROOT + j) * K_N + line;
+                if (state->values[cell] == 0){
+                    columns[k] |= K_NAME(kernel_candidates)(state, cell);
+                }
+            }
+        }
+        int band = (line / KERNEL_ROOT) * KERNEL_ROOT;
+        for (k = 0; k < KERNEL_ROOT; ++k){
+            KERNEL_MASK row_only = K_NAME(kernel_locked)(rows, k);
+            KERNEL_MASK column_only = K_NAME(kernel_locked)(columns, k);
+            for (other = band; other < band + KERNEL_ROOT; ++other){
+                if (other == line){
+                    continue;
+                }
+                for (j = 0; j < KERNEL_ROOT; ++j){
+                    if (row_only){
+                        progress |= K_NAME(kernel_eliminate)(state, other * K_N + k * KERNEL_ROOT + j, row_only);
+                    }
+                    if (column_only){
+                        progress |= K_NAME(kernel_eliminate)(state, (k * KERNEL_ROOT + j) * K_N + other, column_only);
+                    }
+                }
+            }
+        }
+    }
+    return progress;
+}
+
+/**
+ * Fills naked and hidden singles and, once those stall, applies locked
+ * candidates, until nothing else can be deduced.
+ *
+ * @param state State of the board.
+ * @param isa Instruction set of the candidate sweep.
+ * @return Returns the number of cells filled, or -1 if the board is left without a solution.
+ */
+static int K_NAME(kernel_propagate)(struct K_NAME(KernelState) * state, int isa){
+    int filled = 0;
+    for (;;){
+        int naked = K_NAME(kernel_naked_singles)(state, isa);
+        if (naked < 0){
+            return -1;
+        }
+
+        int hidden = K_NAME(kernel_hidden_singles)(state);
+        if (hidden < 0){
+            return -1;
+        }
+        filled += naked + hidden;
+        if (naked || hidden){
+            continue;
+        }
+
+        if (!K_NAME(kernel_locked_candidates)(state)){
+            return filled;
+        }
+    }
+}
+
+/**
+ * Selects the cell to branch on, the first empty cell in row-major order or
+ * the one with the fewest legal digits, ties broken by the number of empty
+ * cells sharing its row, column and sub grid. A cell with one legal digit or
+ * none is taken as soon as it is found, in row-major order.
+ *
+ * @param state State of the board.
+ * @param branching BRANCH_FIRST or BRANCH_MRV.
+ * @param isa Instruction set of the candidate sweep.
+ * @return Returns the index of the cell, or -1 if the board is full.
+ */
+static int K_NAME(kernel_select)(struct K_NAME(KernelState) * state, int branching, int isa){
+    uint8_t counts[K_CELLS + K_PAD];
+    int cell, best = -1, best_count = K_FILLED, best_degree = -1;
+
+    if (branching == BRANCH_FIRST){
+        for (cell = 0; cell < K_CELLS; ++cell){
+            if (state->values[cell] == 0){
+                return cell;
+            }
+        }
+        return -1;
+    }
+
+    K_NAME(kernel_sweep)(state, counts, isa);
+    for (cell = 0; cell < K_CELLS; ++cell){
+        if (counts[cell] < best_count){
+            best_count = counts[cell];
+        }
+    }
+    if (best_count == K_FILLED){
+        return -1;
+    }
+
+    if (best_count <= 1){
+        for (cell = 0; counts[cell] > 1; ++cell);
+        return cell;
+    }
+
+    for (cell = 0; cell < K_CELLS; ++cell){
+        if (counts[cell] != best_count){
+            continue;
+        }
+        int degree = state->row_open[cell / K_N] + state->column_open[cell % K_N] + state->grid_open[K_GRID(cell)];
+        if (degree > best_degree){
+            best = cell;
+            best_degree = degree;
+        }
+    }
+    return best;
+}
+
+/**
+ * Solves a board of this kernel's size with an explicit-stack search that
+ * copies the state on every decision.
+ *
+ * @param buffers Stacks of the search, grown as needed and kept; NULL to allocate them for this call only.
+ * @param values Numbers of the board, row-major with 0 for empty cells; holds the solution if one is found.
+ * @param branching BRANCH_FIRST or BRANCH_MRV.
+ * @param propagation Non-zero to propagate after every number placed.
+ * @param isa Instruction set of the candidate sweep.
+ * @param stats Counters of the worker, the states searched, backtracks and cells propagated are added.
+ * @param stop Called every KERNEL_POLL_INTERVAL decisions with data, or NULL; the search gives up once it returns non-zero.
+ * @param data Argument of the stop hook.
+ * @return Returns non-zero if the board has a solution, zero if it has none or the search gave up.
+ */
+static int K_NAME(kernel_solve)(KernelStack * buffers, uint8_t * values, int branching, int propagation, int isa,
+                                Stats * stats, int (*stop)(void * data), void * data){
+    KernelStack local = {NULL, NULL, 0, 0};
+    KernelStack * owned = buffers != NULL ? buffers : &local;
+    int capacity = kernel_reserve(owned, KERNEL_CAPACITY, sizeof(struct K_NAME(KernelState)),
+                                  sizeof(struct K_NAME(KernelFrame)));
+    int polls = 0;
+    struct K_NAME(KernelState) * stack = owned->states;
+    struct K_NAME(KernelFrame) * frames = owned->frames;
+    int cell, depth = 0, solved = 0, filled;
+
+    memset(stack, 0, sizeof(struct K_NAME(KernelState)));
+    memset(stack[0].row_open, K_N, K_N);
+    memset(stack[0].column_open, K_N, K_N);
+    memset(stack[0].grid_open, K_N, K_N);
+    for (cell = 0; cell < K_CELLS; ++cell){
+        if (values[cell] != 0){
+            K_NAME(kernel_place)(&stack[0], cell, values[cell]);
+        }
+    }
+    stats->nodes++;
+    if (propagation){
+        if ((filled = K_NAME(kernel_propagate)(&stack[0], isa)) < 0){
+            goto done;
+        }
+        stats->propagations += filled;
+    }
+    if ((cell = K_NAME(kernel_select)(&stack[0], branching, isa)) < 0){
+        memcpy(values, stack[0].values, K_CELLS);
+        solved = 1;
+        goto done;
+    }
+    frames[0].cell = cell;
+    frames[0].candidates = K_NAME(kernel_candidates)(&stack[0], cell);
+    depth = 1;
+
+    while (depth > 0){
+        struct K_NAME(KernelFrame) * frame = &frames[depth - 1];
+        if (frame->candidates == 0){
+            depth--;
+            stats->backtracks++;
+            continue;
+        }
+        if (stop != NULL && ++polls == KERNEL_POLL_INTERVAL){
+            polls = 0;
+            if (stop(data)){
+                break;
+            }
+        }
+        int number = KERNEL_FIRST(frame->candidates);
+        frame->candidates &= frame->candidates - 1;
+        cell = frame->cell;
+
+        if (depth == capacity){
+            capacity = kernel_reserve(owned, capacity * 2, sizeof(struct K_NAME(KernelState)), sizeof(struct K_NAME(KernelFrame)));
+            stack = owned->states;
+            frames = owned->frames;
+        }
+
+        // the state of the decision is kept, the branch works on a copy
+        struct K_NAME(KernelState) * next = &stack[depth];
+        *next = stack[depth - 1];
+        stats->nodes++;
+        K_NAME(kernel_place)(next, cell, number);
+        if (propagation){
+            if ((filled = K_NAME(kernel_propagate)(next, isa)) < 0){
+                continue;
+            }
+            stats->propagations += filled;
+        }
+        if ((cell = K_NAME(kernel_select)(next, branching, isa)) < 0){
+            memcpy(values, next->values, K_CELLS);
+            solved = 1;
+            break;
+        }
+        frames[depth].cell = cell;
+        frames[depth].candidates = K_NAME(kernel_candidates)(next, cell);
+        depth++;
+    }
+
+done:
+    if (buffers == NULL){
+        free(local.states);
+        free(local.frames);
+    }
+    return solved;
+}
+
+#undef K_N
+#undef K_CELLS
+#undef K_FULL
+#undef K_BIT
+#undef K_GRID
+#undef K_NAME
+#undef K_LANES
+#undef K_PAD
+#undef K_FILLED
@@ -0,0 +1,102 @@
+#ifndef MASK_H
+#define MASK_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// 64-bit words of a mask and the digits it can hold
+#define MASK_WORDS 2
+#define MASK_BITS (MASK_WORDS * 64)
+
+
+////////////////////////////////////////////////////////////
+//// Types
+////////////////////////////////////////////////////////////
+// one bit per digit, bit (d - 1) is set when digit d is used; the bitwise
+// operators work on the whole mask, the helpers below split it in words
+typedef unsigned __int128 Mask;
+
+
+////////////////////////////////////////////////////////////
+//// Inline Functions
+////////////////////////////////////////////////////////////
+
+/**
+ * Mask with only the bit of a digit set.
+ *
+ * @param number Digit in the interval [1, MASK_BITS].
+ * @return Returns the mask of the digit.
+ */
+static inline Mask mask_of(int number){
+    return (Mask) 1 << (number - 1);
+}
+
+/**
+ * Mask with the digits from 1 to n set.
+ *
+ * @param n Number of digits, in the interval [1, MASK_BITS].
+ * @return Returns the mask of the digits.
+ */
+static inline Mask mask_full(int n){
+    return ~(Mask) 0 >> (MASK_BITS - n);
+}
+
+/**
+ * Low 64-bit word of a mask, digits 1 to 64.
+ *
+ * @param mask Mask of digits.
+ * @return Returns the word.
+ */
+static inline uint64_t mask_low(Mask mask){
+    return (uint64_t) mask;
+}
+
+/**
+ * High 64-bit word of a mask, digits 65 to 128.
+ *
+ * @param mask Mask of digits.
+ * @return Returns the word.
+ */
+static inline uint64_t mask_high(Mask mask){
+    return (uint64_t) (mask >> 64);
+}
+
+/**
+ * Number of digits in a mask.
+ *
+ * @param mask Mask of digits.
+ * @return Returns the number of bits set.
+ */
+static inline int mask_count(Mask mask){
+    return __builtin_popcountll(mask_low(mask)) + __builtin_popcountll(mask_high(mask));
+}
+
+/**
+ * Lowest digit in a mask.
+ *
+ * @param mask Mask of digits, must not be empty.
+ * @return Returns the lowest digit set in the mask.
+ */
+static inline int mask_first(Mask mask){
+    uint64_t low = mask_low(mask);
+    return low ? __builtin_ctzll(low) + 1 : __builtin_ctzll(mask_high(mask)) + 65;
+}
+
+/**
+ * Removes the lowest digit from a mask, to iterate over its digits with
+ * mask_first.
+ *
+ * @param mask Mask of digits.
+ * @return Returns the mask without its lowest digit.
+ */
+static inline Mask mask_drop_first(Mask mask){
+    return mask & (mask - 1);
+}
+
+#endif
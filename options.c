@@ -0,0 +1,172 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "options.h"
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static int parse_count(char * text, int * count);
+
+
+/**
+ * Parses the command line of a solver.
+ *
+ * Accepted arguments, after the required input filename:
+ * `-t` show the states searched and the elapsed time,
+ * `-to` show only the elapsed time (takes precedence over `-t`),
+ * `--branch=first|mrv` cell selection used by the search (default mrv),
+ * `--propagation=on|off` deduce forced cells before and during the search (default on),
+ * `--engine=backtrack|dlx` search engine (default backtrack),
+ * `--kernel=on|off` solve with the search specialized for the board size when there is one (default on),
+ * `--tasks=K` tasks the OpenMP solver keeps in flight per thread (default 2),
+ * `--cutoff=N` empty cells at or below which the parallel solvers stop splitting work (default the board width),
+ * `--frontier=K` subproblems per worker the parallel solvers expand the puzzle into before searching (default 4),
+ * `--frontier-depth=D` levels of decisions at most of that expansion (default 8),
+ * `--bind=none|compact|scatter` pin the OpenMP worker threads to processors (default none),
+ * `--schedule=master|steal` share the MPI work through the master or by stealing between ranks (default master),
+ * `--checkpoint=FILE` save the open subproblems of the search to FILE every few seconds (default none),
+ * `--checkpoint-interval=S` seconds between two checkpoints, 0 for one after every slice of the search (default 60),
+ * `--resume` go on with the search saved in the checkpoint file instead of starting over,
+ * `--batch` the input file holds many puzzles, grids or one line each, solved side by side by the workers,
+ * `--stats=json|none` print the search statistics of every worker after the result (default none).
+ *
+ * @param options Options to fill.
+ * @param argc Number of command line arguments.
+ * @param argv Array of command line arguments.
+ * @return Returns non-zero if the command line is valid, otherwise prints the error and returns zero.
+ */
+int options_parse(Options * options, int argc, char * argv[]){
+    options->filename = NULL;
+    options->time_flag = 0;
+    options->time_only_flag = 0;
+    options->branching = BRANCH_MRV;
+    options->propagation = 1;
+    options->engine = ENGINE_BACKTRACK;
+    options->kernel = 1;
+    options->tasks = 2;
+    options->cutoff = -1;
+    options->frontier = 4;
+    options->frontier_depth = 8;
+    options->bind = BIND_NONE;
+    options->schedule = SCHEDULE_MASTER;
+    options->stats = STATS_NONE;
+    options->checkpoint = NULL;
+    options->checkpoint_interval = 60;
+    options->resume = 0;
+    options->batch = 0;
+
+    if (argc < 2) {
+        printf("ERROR: Missing arguments.\n");
+        return 0;
+    }
+    options->filename = argv[1];
+
+    int i;
+    for (i = 2; i < argc; ++i){
+        if (strcmp(argv[i], "-t") == 0) {
+            options->time_flag = 1;
+        } else if (strcmp(argv[i], "-to") == 0) {
+            options->time_only_flag = 1;
+        } else if (strcmp(argv[i], "--branch=first") == 0) {
+            options->branching = BRANCH_FIRST;
+        } else if (strcmp(argv[i], "--branch=mrv") == 0) {
+            options->branching = BRANCH_MRV;
+        } else if (strcmp(argv[i], "--propagation=on") == 0) {
+            options->propagation = 1;
+        } else if (strcmp(argv[i], "--propagation=off") == 0) {
+            options->propagation = 0;
+        } else if (strcmp(argv[i], "--engine=backtrack") == 0) {
+            options->engine = ENGINE_BACKTRACK;
+        } else if (strcmp(argv[i], "--engine=dlx") == 0) {
+            options->engine = ENGINE_DLX;
+        } else if (strcmp(argv[i], "--kernel=on") == 0) {
+            options->kernel = 1;
+        } else if (strcmp(argv[i], "--kernel=off") == 0) {
+            options->kernel = 0;
+        } else if (strncmp(argv[i], "--tasks=", 8) == 0) {
+            if (!parse_count(argv[i] + 8, &options->tasks) || options->tasks == 0) {
+                printf("ERROR: Invalid argument %s\n", argv[i]);
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--cutoff=", 9) == 0) {
+            if (!parse_count(argv[i] + 9, &options->cutoff)) {
+                printf("ERROR: Invalid argument %s\n", argv[i]);
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--frontier=", 11) == 0) {
+            if (!parse_count(argv[i] + 11, &options->frontier)) {
+                printf("ERROR: Invalid argument %s\n", argv[i]);
+                return 0;
+            }
+        } else if (strncmp(argv[i], "--frontier-depth=", 17) == 0) {
+            if (!parse_count(argv[i] + 17, &options->frontier_depth)) {
+                printf("ERROR: Invalid argument %s\n", argv[i]);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--bind=none") == 0) {
+            options->bind = BIND_NONE;
+        } else if (strcmp(argv[i], "--bind=compact") == 0) {
+            options->bind = BIND_COMPACT;
+        } else if (strcmp(argv[i], "--bind=scatter") == 0) {
+            options->bind = BIND_SCATTER;
+        } else if (strcmp(argv[i], "--schedule=master") == 0) {
+            options->schedule = SCHEDULE_MASTER;
+        } else if (strcmp(argv[i], "--schedule=steal") == 0) {
+            options->schedule = SCHEDULE_STEAL;
+        } else if (strcmp(argv[i], "--stats=json") == 0) {
+            options->stats = STATS_JSON;
+        } else if (strcmp(argv[i], "--stats=none") == 0) {
+            options->stats = STATS_NONE;
+        } else if (strncmp(argv[i], "--checkpoint=", 13) == 0 && argv[i][13] != '\0') {
+            options->checkpoint = argv[i] + 13;
+        } else if (strncmp(argv[i], "--checkpoint-interval=", 22) == 0) {
+            if (!parse_count(argv[i] + 22, &options->checkpoint_interval)) {
+                printf("ERROR: Invalid argument %s\n", argv[i]);
+                return 0;
+            }
+        } else if (strcmp(argv[i], "--resume") == 0) {
+            options->resume = 1;
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            options->batch = 1;
+        } else {
+            printf("ERROR: Unknown argument %s\n", argv[i]);
+            return 0;
+        }
+    }
+
+    if (options->time_only_flag) {
+        options->time_flag = 0;
+    }
+    if (options->resume && options->checkpoint == NULL) {
+        printf("ERROR: --resume needs --checkpoint=FILE\n");
+        return 0;
+    }
+    if (options->batch && options->checkpoint != NULL) {
+        printf("ERROR: --checkpoint does not apply to --batch\n");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * Parses a non-negative decimal count of an option value.
+ *
+ * @param text Value of the option, after the '='.
+ * @param count Count reference, only set if the value is valid.
+ * @return Returns non-zero if the whole value is a non-negative number.
+ */
+static int parse_count(char * text, int * count){
+    char * end;
+    long value = strtol(text, &end, 10);
+    if (end == text || *end != '\0' || value < 0 || value > 1000000) {
+        return 0;
+    }
+    *count = (int) value;
+    return 1;
+}
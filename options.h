@@ -0,0 +1,79 @@
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// branch on the first empty cell in row-major order
+#define BRANCH_FIRST 0
+// branch on the empty cell with the fewest candidates
+#define BRANCH_MRV 1
+
+// backtracking over the constraint state, driven by an explicit stack of decisions
+#define ENGINE_BACKTRACK 0
+// dancing links exact cover search
+#define ENGINE_DLX 1
+
+// workers left to the operating system
+#define BIND_NONE 0
+// workers pinned to consecutive cores, filling a socket before the next one
+#define BIND_COMPACT 1
+// workers pinned round-robin over the sockets, then over their cores
+#define BIND_SCATTER 2
+
+// work items handed out by the master rank
+#define SCHEDULE_MASTER 0
+// every rank searches and idle ranks steal from random peers
+#define SCHEDULE_STEAL 1
+
+// no statistics report
+#define STATS_NONE 0
+// search statistics of every worker as JSON
+#define STATS_JSON 1
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Command line options shared by every solver.
+ */
+struct Options {
+    char * filename;
+    int time_flag;
+    int time_only_flag;
+    int branching;
+    int propagation;
+    int engine;
+    int kernel;
+    // tasks allowed in flight per thread (OpenMP)
+    int tasks;
+    // empty cells at or below which a branch is never spawned, -1 for the board width (OpenMP and MPI)
+    int cutoff;
+    // subproblems per worker and levels at most of the breadth first expansion of the puzzle (OpenMP and MPI)
+    int frontier;
+    int frontier_depth;
+    // placement of the worker threads on the processors (OpenMP)
+    int bind;
+    // how the work is shared between the ranks (MPI)
+    int schedule;
+    // report of the search statistics printed after the result
+    int stats;
+    // file the open subproblems are saved to, NULL for none, seconds between two saves
+    // and whether the search goes on from the file (backtracking engine)
+    char * checkpoint;
+    int checkpoint_interval;
+    int resume;
+    // the input file holds many puzzles, solved one per worker at a time
+    int batch;
+};
+
+typedef struct Options Options;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+int options_parse(Options * options, int argc, char * argv[]);
+
+#endif
@@ -0,0 +1,136 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "pool.h"
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static void grow(Pool * pool);
+
+
+/**
+ * Creates an empty pool, chunks are only allocated on the first get.
+ *
+ * @param size Bytes of every block, at least the size of a pointer.
+ * @param release Function called on every block when the pool is freed, or NULL.
+ * @return Returns the new pool.
+ */
+Pool * pool_create(size_t size, void (*release)(void * block)){
+    Pool * pool = aligned_alloc(POOL_ALIGNMENT, sizeof(Pool));
+    // every block starts on a cache line, and holds the free list link
+    if (size < sizeof(void *)){
+        size = sizeof(void *);
+    }
+    pool->size = (size + POOL_ALIGNMENT - 1) / POOL_ALIGNMENT * POOL_ALIGNMENT;
+    pool->release = release;
+    pool->free = NULL;
+    pool->remote = NULL;
+    pool->used = 0;
+    pool->peak = 0;
+    pool->blocks = 0;
+    pool->chunk_count = 0;
+    pool->chunk_capacity = 0;
+    pool->chunks = NULL;
+    return pool;
+}
+
+/**
+ * Takes a block out of the pool, only called by the owner of the pool.
+ *
+ * @param pool Pool to take the block from.
+ * @return Returns the block, zeroed if it was never used, apart from the link if it was.
+ */
+void * pool_get(Pool * pool){
+    if (pool->free == NULL){
+        // takes over every block other threads gave back at once
+        pool->free = __atomic_exchange_n(&pool->remote, NULL, __ATOMIC_ACQUIRE);
+    }
+    if (pool->free == NULL){
+        grow(pool);
+    }
+
+    void * block = pool->free;
+    pool->free = *(void **) block;
+    int used = __atomic_add_fetch(&pool->used, 1, __ATOMIC_RELAXED);
+    if (used > pool->peak){
+        pool->peak = used;
+    }
+    return block;
+}
+
+/**
+ * Gives a block back to the pool, only called by the owner of the pool.
+ *
+ * @param pool Pool the block was taken from.
+ * @param block Block to give back.
+ */
+void pool_put(Pool * pool, void * block){
+    *(void **) block = pool->free;
+    pool->free = block;
+    __atomic_fetch_sub(&pool->used, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Gives a block back to the pool from a thread other than its owner.
+ *
+ * @param pool Pool the block was taken from.
+ * @param block Block to give back.
+ */
+void pool_put_remote(Pool * pool, void * block){
+    void * head = __atomic_load_n(&pool->remote, __ATOMIC_RELAXED);
+    do {
+        *(void **) block = head;
+    } while (!__atomic_compare_exchange_n(&pool->remote, &head, block, 1,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    __atomic_fetch_sub(&pool->used, 1, __ATOMIC_RELAXED);
+}
+
+/**
+ * Free's a pool and every chunk of it, whether its blocks were given back
+ * or not.
+ *
+ * @param pool Pool to free.
+ */
+void pool_free(Pool * pool){
+    if (pool != NULL) {
+        int chunk, block;
+        for (chunk = 0; chunk < pool->chunk_count; ++chunk){
+            if (pool->release != NULL){
+                for (block = 0; block < POOL_CHUNK_BLOCKS; ++block){
+                    pool->release((char *) pool->chunks[chunk] + block * pool->size);
+                }
+            }
+            free(pool->chunks[chunk]);
+        }
+        free(pool->chunks);
+        free(pool);
+    }
+}
+
+/**
+ * Allocates a new chunk and puts its blocks on the free list.
+ *
+ * @param pool Pool to grow.
+ */
+static void grow(Pool * pool){
+    if (pool->chunk_count == pool->chunk_capacity){
+        pool->chunk_capacity = pool->chunk_capacity > 0 ? 2 * pool->chunk_capacity : 4;
+        pool->chunks = realloc(pool->chunks, pool->chunk_capacity * sizeof(void *));
+    }
+
+    char * chunk = aligned_alloc(POOL_ALIGNMENT, POOL_CHUNK_BLOCKS * pool->size);
+    memset(chunk, 0, POOL_CHUNK_BLOCKS * pool->size);
+    pool->chunks[pool->chunk_count++] = chunk;
+    pool->blocks += POOL_CHUNK_BLOCKS;
+
+    int block;
+    for (block = POOL_CHUNK_BLOCKS - 1; block >= 0; --block){
+        *(void **) (chunk + block * pool->size) = pool->free;
+        pool->free = chunk + block * pool->size;
+    }
+}
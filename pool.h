@@ -0,0 +1,63 @@
+#ifndef POOL_H
+#define POOL_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stddef.h>
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// blocks start on a cache line
+#define POOL_ALIGNMENT 64
+// blocks carved out of every chunk
+#define POOL_CHUNK_BLOCKS 16
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Fixed-size blocks carved out of large chunks and recycled through a free
+ * list, so once the pool has grown to the number of blocks in use at once
+ * getting and putting back a block never reaches the allocator.
+ *
+ * A pool is owned by one thread, the only one that gets blocks from it and
+ * puts them back with pool_put. Other threads give blocks back with
+ * pool_put_remote, onto a separate list the owner takes over when its own
+ * list runs out.
+ *
+ * New blocks are zeroed, recycled blocks are handed out as they were put
+ * back but for their first pointer, the free list link, so a block can keep
+ * buffers it allocated on its first use.
+ */
+struct Pool {
+    size_t size;
+    // called on every block by pool_free, to free the buffers they kept
+    void (*release)(void * block);
+    void * free;
+    // blocks given back by other threads, only changed atomically
+    void * remote __attribute__((aligned(POOL_ALIGNMENT)));
+    int used __attribute__((aligned(POOL_ALIGNMENT)));
+    int peak;
+    int blocks;
+    int chunk_count;
+    int chunk_capacity;
+    void ** chunks;
+};
+
+typedef struct Pool Pool;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Pool * pool_create(size_t size, void (*release)(void * block));
+void * pool_get(Pool * pool);
+void pool_put(Pool * pool, void * block);
+void pool_put_remote(Pool * pool, void * block);
+void pool_free(Pool * pool);
+
+#endif
@@ -0,0 +1,392 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "dlx.h"
+#include "puzzles.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// bytes of the file read at once, and puzzles a batch starts with room for
+#define READ_CHUNK 65536
+#define PUZZLES_CAPACITY 64
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static char * next_token(char ** cursor, size_t * length);
+static int parse_number(char * token, size_t length);
+static uint8_t * add(Puzzles * puzzles, int line);
+static int consistent(int root_n, uint8_t * values);
+
+
+/**
+ * Creates an empty batch of puzzles.
+ *
+ * @param root_n Square root of the number of rows and columns of every puzzle.
+ * @param capacity Puzzles to make room for, more are added as needed.
+ * @return Returns the new batch, with no puzzle.
+ */
+Puzzles * puzzles_create(int root_n, int capacity){
+    Puzzles * puzzles = malloc(sizeof(Puzzles));
+    int n = root_n * root_n;
+    puzzles->root_n = root_n;
+    puzzles->n = n;
+    puzzles->count = 0;
+    puzzles->capacity = capacity > 0 ? capacity : 1;
+    puzzles->cells = malloc((size_t) puzzles->capacity * n * n);
+    puzzles->solutions = malloc((size_t) puzzles->capacity * n * n);
+    puzzles->solved = calloc(puzzles->capacity, 1);
+    puzzles->lines = calloc(puzzles->capacity, 1);
+    return puzzles;
+}
+
+/**
+ * Reads every puzzle of a batch file. A puzzle is either in the input
+ * format, the square root of n followed by the n * n numbers, or on one
+ * line of 81 (9x9) or 16 (4x4) characters, a digit per cell with 0 or '.'
+ * for an empty one. Both may be mixed in a file but the puzzles must all
+ * be of the same size. The file is read whole and parsed in memory.
+ *
+ * @param file File to read from.
+ * @return Returns the puzzles, or NULL if the file holds none or is not a batch file.
+ */
+Puzzles * puzzles_read(FILE * file){
+    size_t size = 0, capacity = READ_CHUNK, bytes;
+    char * text = malloc(capacity + 1);
+    while ((bytes = fread(text + size, 1, capacity - size, file)) > 0){
+        size += bytes;
+        if (size == capacity){
+            capacity *= 2;
+            text = realloc(text, capacity + 1);
+        }
+    }
+    text[size] = '\0';
+
+    Puzzles * puzzles = NULL;
+    char * cursor = text, * token;
+    size_t length;
+    int valid = 1;
+    while (valid && (token = next_token(&cursor, &length)) != NULL){
+        int line = length == 81 || length == 16;
+        int root_n = length == 81 ? 3 : length == 16 ? 2 : parse_number(token, length);
+        if (root_n < 1 || !constraints_supported(root_n * root_n) ||
+            (puzzles != NULL && root_n != puzzles->root_n)){
+            valid = 0;
+            break;
+        }
+        if (puzzles == NULL){
+            puzzles = puzzles_create(root_n, PUZZLES_CAPACITY);
+        }
+
+        uint8_t * cells = add(puzzles, line);
+        int n = puzzles->n, cell, number;
+        for (cell = 0; cell < n * n && valid; ++cell){
+            if (line){
+                number = token[cell] == '.' ? 0 : token[cell] - '0';
+            } else {
+                token = next_token(&cursor, &length);
+                number = token != NULL ? parse_number(token, length) : -1;
+            }
+            valid = number >= 0 && number <= n;
+            cells[cell] = number;
+        }
+    }
+    free(text);
+
+    if (!valid || puzzles == NULL){
+        puzzles_free(puzzles);
+        return NULL;
+    }
+    return puzzles;
+}
+
+/**
+ * Solves a puzzle of a batch into its solution: with the kernel specialized
+ * for its size when there is one, otherwise with the search over a
+ * constraint state, or with Dancing Links for `--engine=dlx`. The kernel
+ * runs on the stacks of the worker and the search on its constraint state,
+ * trail and stack of decisions, so neither allocates per puzzle and the
+ * constraint state is only cleared as far as the board reaches; Dancing
+ * Links builds its matrix for every puzzle.
+ *
+ * @param puzzles Puzzles of the batch.
+ * @param index Index of the puzzle to solve.
+ * @param scratch Buffers of the worker, overwritten.
+ * @param options Options of the solver.
+ * @param stats Counters of the worker.
+ * @return Returns non-zero if the puzzle has a solution.
+ */
+int puzzles_solve(Puzzles * puzzles, int index, PuzzlesScratch * scratch, Options * options, Stats * stats){
+    int root_n = puzzles->root_n, n = puzzles->n;
+    uint8_t * values = puzzles_solution(puzzles, index);
+    memcpy(values, puzzles_cells(puzzles, index), n * n);
+    stats->executed++;
+
+    int solved = consistent(root_n, values);
+    if (!solved){
+        // the given numbers conflict
+    } else if (options->engine == ENGINE_DLX){
+        Dlx * dlx = dlx_create(root_n, values);
+        solved = dlx_solve(dlx, values);
+        stats->nodes += dlx->states;
+        stats->backtracks += dlx->backtracks;
+        dlx_free(dlx);
+    } else if (options->kernel && kernel_supported(root_n)){
+        solved = kernel_solve_on(scratch->kernel, root_n, values, options, stats, NULL, NULL);
+    } else {
+        if (scratch->constraints == NULL){
+            scratch->constraints = malloc(sizeof(Constraints));
+            scratch->trail = trail_create();
+        }
+        Constraints * constraints = scratch->constraints;
+        Trail * trail = scratch->trail;
+        constraints_init(constraints, root_n);
+        trail->count = 0;
+        int row, column;
+        for (row = 0; row < n; ++row){
+            for (column = 0; column < n; ++column){
+                if (values[row * n + column] != 0){
+                    constraints_place(constraints, row, column, values[row * n + column]);
+                }
+            }
+        }
+        solved = !options->propagation || constraints_propagate(constraints, trail);
+        if (solved){
+            if (scratch->search == NULL){
+                scratch->search = search_create(constraints, trail, options);
+            } else {
+                search_init(scratch->search, constraints, trail, options);
+            }
+            Search * search = scratch->search;
+            solved = search_run(search, 0) == SEARCH_SOLVED;
+            stats->nodes += search->states;
+            stats->backtracks += search->backtracks;
+            stats->propagations += search->propagations;
+        }
+        if (solved){
+            memcpy(values, constraints->values, n * n);
+        }
+    }
+    puzzles->solved[index] = solved != 0;
+    return solved;
+}
+
+/**
+ * Counts the puzzles of a batch that were solved.
+ *
+ * @param puzzles Puzzles of the batch.
+ * @return Returns the number of puzzles with a solution.
+ */
+int puzzles_solved(Puzzles * puzzles){
+    int count = 0, index;
+    for (index = 0; index < puzzles->count; ++index){
+        count += puzzles->solved[index];
+    }
+    return count;
+}
+
+/**
+ * Prints the solutions of a batch in the order of the file, each in the
+ * format its puzzle was given in: a grid like board_print, or one line of
+ * digits. A puzzle with no solution prints "No solution".
+ *
+ * @param file File to print to.
+ * @param puzzles Puzzles of the batch, solved.
+ */
+void puzzles_print(FILE * file, Puzzles * puzzles){
+    int n = puzzles->n, index, row, column;
+    // up to two digits and a space per cell and a newline per row
+    char * buffer = malloc(3 * n * n + n + 1);
+    for (index = 0; index < puzzles->count; ++index){
+        if (!puzzles->solved[index]){
+            fputs("No solution\n", file);
+            continue;
+        }
+        uint8_t * values = puzzles_solution(puzzles, index);
+        size_t length = 0;
+        for (row = 0; row < n; ++row){
+            for (column = 0; column < n; ++column){
+                int number = values[row * n + column];
+                if (number >= 10){
+                    buffer[length++] = '0' + number / 10;
+                }
+                buffer[length++] = '0' + number % 10;
+                if (!puzzles->lines[index]){
+                    buffer[length++] = ' ';
+                }
+            }
+            if (!puzzles->lines[index] || row == n - 1){
+                buffer[length++] = '\n';
+            }
+        }
+        fwrite(buffer, 1, length, file);
+    }
+    free(buffer);
+}
+
+/**
+ * Prints the result of a batch accordingly to the flags: the solutions
+ * unless `-to`, then the puzzles solved and the puzzles solved per second,
+ * and the elapsed time with `-t` or `-to`.
+ *
+ * @param file File to print to.
+ * @param puzzles Puzzles of the batch, solved.
+ * @param options Options of the solver.
+ * @param elapsed Seconds from the start of the solver until the batch was solved.
+ */
+void puzzles_report(FILE * file, Puzzles * puzzles, Options * options, double elapsed){
+    if (!options->time_only_flag){
+        puzzles_print(file, puzzles);
+    }
+    fprintf(file, "Solved %d of %d puzzles, %f puzzles/s\n", puzzles_solved(puzzles), puzzles->count,
+            elapsed > 0 ? puzzles->count / elapsed : 0);
+    if (options->time_flag || options->time_only_flag){
+        fprintf(file, "Elapsed time: %f (s)\n", elapsed);
+    }
+}
+
+/**
+ * Free's a batch of puzzles.
+ *
+ * @param puzzles Puzzles to free.
+ */
+void puzzles_free(Puzzles * puzzles){
+    if (puzzles != NULL) {
+        free(puzzles->cells);
+        free(puzzles->solutions);
+        free(puzzles->solved);
+        free(puzzles->lines);
+        free(puzzles);
+    }
+}
+
+/**
+ * Creates the buffers a worker solves the puzzles of a batch with.
+ *
+ * @return Returns the new buffers, the constraint state and trail are created when first needed.
+ */
+PuzzlesScratch * puzzles_scratch_create(){
+    PuzzlesScratch * scratch = malloc(sizeof(PuzzlesScratch));
+    scratch->kernel = kernel_stack_create();
+    scratch->constraints = NULL;
+    scratch->trail = NULL;
+    scratch->search = NULL;
+    return scratch;
+}
+
+/**
+ * Free's the buffers of a worker.
+ *
+ * @param scratch Buffers to free.
+ */
+void puzzles_scratch_free(PuzzlesScratch * scratch){
+    if (scratch != NULL) {
+        kernel_stack_free(scratch->kernel);
+        free(scratch->constraints);
+        trail_free(scratch->trail);
+        search_free(scratch->search);
+        free(scratch);
+    }
+}
+
+/**
+ * Finds the next run of characters that are not white space.
+ *
+ * @param cursor Position to search from, moved past the token.
+ * @param length Set to the length of the token.
+ * @return Returns the first character of the token, or NULL at the end of the text.
+ */
+static char * next_token(char ** cursor, size_t * length){
+    char * start = *cursor;
+    while (*start == ' ' || *start == '\n' || *start == '\r' || *start == '\t'){
+        start++;
+    }
+    if (*start == '\0'){
+        return NULL;
+    }
+    char * end = start;
+    while (*end != '\0' && *end != ' ' && *end != '\n' && *end != '\r' && *end != '\t'){
+        end++;
+    }
+    *cursor = end;
+    *length = end - start;
+    return start;
+}
+
+/**
+ * Parses a token of at most three decimal digits.
+ *
+ * @param token First character of the token.
+ * @param length Length of the token.
+ * @return Returns the number, or -1 if the token is not one.
+ */
+static int parse_number(char * token, size_t length){
+    if (length == 0 || length > 3){
+        return -1;
+    }
+    int number = 0;
+    size_t i;
+    for (i = 0; i < length; ++i){
+        if (token[i] < '0' || token[i] > '9'){
+            return -1;
+        }
+        number = number * 10 + token[i] - '0';
+    }
+    return number;
+}
+
+/**
+ * Appends an empty puzzle to a batch, growing it if it is full.
+ *
+ * @param puzzles Puzzles of the batch.
+ * @param line Whether the puzzle was given on one line.
+ * @return Returns the cells of the new puzzle, to be filled.
+ */
+static uint8_t * add(Puzzles * puzzles, int line){
+    if (puzzles->count == puzzles->capacity){
+        size_t size = (size_t) puzzles->n * puzzles->n;
+        puzzles->capacity *= 2;
+        puzzles->cells = realloc(puzzles->cells, puzzles->capacity * size);
+        puzzles->solutions = realloc(puzzles->solutions, puzzles->capacity * size);
+        puzzles->solved = realloc(puzzles->solved, puzzles->capacity);
+        puzzles->lines = realloc(puzzles->lines, puzzles->capacity);
+    }
+    puzzles->solved[puzzles->count] = 0;
+    puzzles->lines[puzzles->count] = line;
+    return puzzles_cells(puzzles, puzzles->count++);
+}
+
+/**
+ * Checks that no number is given twice in a row, column or sub grid.
+ *
+ * @param root_n Square root of the number of rows and columns.
+ * @param values Cells of the puzzle in row-major order, 0 for an empty cell.
+ * @return Returns zero if two of the given numbers conflict.
+ */
+static int consistent(int root_n, uint8_t * values){
+    int n = root_n * root_n, row, column;
+    // numbers seen on every row, column and sub grid, n + 1 flags each
+    uint8_t seen[3 * n * (n + 1)];
+    uint8_t * rows = seen, * columns = seen + n * (n + 1), * grids = seen + 2 * n * (n + 1);
+    memset(seen, 0, sizeof(seen));
+    for (row = 0; row < n; ++row){
+        for (column = 0; column < n; ++column){
+            int number = values[row * n + column];
+            if (number == 0){
+                continue;
+            }
+            int grid = (row / root_n) * root_n + column / root_n;
+            if (rows[row * (n + 1) + number]++ || columns[column * (n + 1) + number]++ ||
+                grids[grid * (n + 1) + number]++){
+                return 0;
+            }
+        }
+    }
+    return 1;
+}
@@ -0,0 +1,114 @@
+#ifndef PUZZLES_H
+#define PUZZLES_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdio.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "constraints.h"
+#include "kernel.h"
+#include "options.h"
+#include "search.h"
+#include "stats.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// puzzles of a batch a thread takes at once, few so a run of hard ones is still shared
+#define PUZZLES_CHUNK 16
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Puzzles of a batch file, all of the same size, in the order of the file.
+ * The cells of every puzzle and of its solution are back to back, n * n
+ * bytes per puzzle, so a range of puzzles is sent or copied at once.
+ */
+struct Puzzles {
+    int root_n;
+    int n;
+    int count;
+    int capacity;
+    uint8_t * cells;
+    uint8_t * solutions;
+    // whether every puzzle was solved, and given on one line instead of as a grid
+    uint8_t * solved;
+    uint8_t * lines;
+};
+
+/**
+ * Buffers a worker reuses for every puzzle of a batch it solves: the
+ * stacks of the kernel, and the constraint state, trail and search for
+ * boards without a kernel, created on the first one.
+ */
+struct PuzzlesScratch {
+    KernelStack * kernel;
+    Constraints * constraints;
+    Trail * trail;
+    Search * search;
+};
+
+typedef struct Puzzles Puzzles;
+typedef struct PuzzlesScratch PuzzlesScratch;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Puzzles * puzzles_create(int root_n, int capacity);
+Puzzles * puzzles_read(FILE * file);
+int puzzles_solve(Puzzles * puzzles, int index, PuzzlesScratch * scratch, Options * options, Stats * stats);
+int puzzles_solved(Puzzles * puzzles);
+void puzzles_print(FILE * file, Puzzles * puzzles);
+void puzzles_report(FILE * file, Puzzles * puzzles, Options * options, double elapsed);
+void puzzles_free(Puzzles * puzzles);
+PuzzlesScratch * puzzles_scratch_create();
+void puzzles_scratch_free(PuzzlesScratch * scratch);
+
+
+////////////////////////////////////////////////////////////
+//// Inline Functions
+////////////////////////////////////////////////////////////
+
+/**
+ * Cells of a puzzle as given.
+ *
+ * @param puzzles Puzzles of the batch.
+ * @param index Index of the puzzle.
+ * @return Returns the n * n cells of the puzzle.
+ */
+static inline uint8_t * puzzles_cells(Puzzles * puzzles, int index){
+    return puzzles->cells + (size_t) index * puzzles->n * puzzles->n;
+}
+
+/**
+ * Cells of the solution of a puzzle, only meaningful once it is solved.
+ *
+ * @param puzzles Puzzles of the batch.
+ * @param index Index of the puzzle.
+ * @return Returns the n * n cells of the solution.
+ */
+static inline uint8_t * puzzles_solution(Puzzles * puzzles, int index){
+    return puzzles->solutions + (size_t) index * puzzles->n * puzzles->n;
+}
+
+/**
+ * Puzzles a thread takes at once out of some shared by a team of threads:
+ * PUZZLES_CHUNK, or fewer when that would leave threads without any.
+ *
+ * @param count Puzzles shared by the team.
+ * @param threads Threads of the team.
+ * @return Returns the number of puzzles, at least one.
+ */
+static inline int puzzles_chunk(int count, int threads){
+    int chunk = count / threads;
+    return chunk < 1 ? 1 : chunk > PUZZLES_CHUNK ? PUZZLES_CHUNK : chunk;
+}
+
+#endif
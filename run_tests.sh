@@ -1,17 +1,110 @@
 #!/bin/bash
 PROGRAM=$1
 NUM_THREADS=${2:-4}
+FAILED=0
+
+
+# Prints OK when the output ($2) holds a solution of the puzzle ($1),
+# NOSOL when it says there is none and FAIL otherwise
+verify() {
+	awk '
+		FNR == NR { for (i = 1; i <= NF; i++) p[np++] = $i; next }
+		{ for (i = 1; i <= NF; i++) s[ns++] = $i }
+		END {
+			if (s[0] == "No") { print "NOSOL"; exit }
+			root = p[0]; n = root * root
+			for (c = 0; c < n * n; c++) {
+				v = s[c] + 0
+				if (v < 1 || v > n || (p[c + 1] != 0 && p[c + 1] != v)) { print "FAIL"; exit }
+				b = int(int(c / n) / root) * root + int((c % n) / root)
+				if (row[int(c / n), v]++ || col[c % n, v]++ || box[b, v]++) { print "FAIL"; exit }
+			}
+			print "OK"
+		}' "$1" "$2"
+}
+
+# Prints the number of puzzles of the batch file ($1) the output ($2)
+# solves, or FAIL when a solution is wrong or the closing count is off
+verify_batch() {
+	awk '
+		FNR == NR { for (i = 1; i <= NF; i++) p[np++] = $i; next }
+		{ for (i = 1; i <= NF; i++) s[ns++] = $i }
+		END {
+			i = 0; j = 0; solved = 0; total = 0
+			while (i < np) {
+				delete row; delete col; delete box
+				line = length(p[i]) > 2
+				if (line) {
+					n = sqrt(length(p[i])); root = sqrt(n)
+					for (c = 0; c < n * n; c++) given[c] = substr(p[i], c + 1, 1) == "." ? 0 : substr(p[i], c + 1, 1)
+					i++
+				} else {
+					root = p[i]; n = root * root
+					for (c = 0; c < n * n; c++) given[c] = p[i + 1 + c]
+					i += 1 + n * n
+				}
+				total++
+				if (s[j] == "No") { j += 2; continue }
+				for (c = 0; c < n * n; c++) {
+					v = line ? substr(s[j], c + 1, 1) + 0 : s[j + c] + 0
+					if (v < 1 || v > n || (given[c] != 0 && given[c] != v)) { print "FAIL"; exit }
+					b = int(int(c / n) / root) * root + int((c % n) / root)
+					if (row[int(c / n), v]++ || col[c % n, v]++ || box[b, v]++) { print "FAIL"; exit }
+				}
+				j += line ? 1 : n * n
+				solved++
+			}
+			if (s[j] != "Solved" || s[j + 1] != solved || s[j + 3] != total) { print "FAIL"; exit }
+			print solved
+		}' "$1" "$2"
+}
+
+# Solves a puzzle ($1) with the remaining arguments as options and checks
+# the solution, or that there is none for the -nosol puzzles
+regression() {
+	local puzzle=$1
+	shift
+	local expected=OK
+	[[ "$puzzle" == *-nosol.txt ]] && expected=NOSOL
+	timeout 300 "${RUN[@]}" ./"$PROGRAM" "$puzzle" "$@" > "$OUTPUT"
+	local result=$(verify "$puzzle" "$OUTPUT")
+	report "$result" "$expected" "$puzzle $*"
+}
+
+# Solves a batch file ($1) with the remaining arguments as options and
+# checks every solution and that $2 puzzles are solved
+regression_batch() {
+	local puzzles=$1
+	local expected=$2
+	shift 2
+	timeout 300 "${RUN[@]}" ./"$PROGRAM" "$puzzles" --batch "$@" > "$OUTPUT"
+	local result=$(verify_batch "$puzzles" "$OUTPUT")
+	report "$result" "$expected" "$puzzles --batch $*"
+}
+
+report() {
+	if [[ "$1" == "$2" ]]; then
+		echo "PASS: $3"
+	else
+		echo "FAIL: $3 (expected $2, got $1)"
+		head -n 3 "$OUTPUT"
+		FAILED=$((FAILED+1))
+	fi
+}
 
 
 if [[ -n "$PROGRAM" ]]; then
 	#Set number of threads
-	
+	RUN=()
+	OUTPUT=$(mktemp)
+	CHECKPOINT=$(mktemp -u)
+
 	printf "\n*******************************************\n"
 	printf "\tSolve all sudoku puzzles.\n\n"
 
-	numfiles=(input/*.in)
+	numfiles=(input/*.txt)
 	numfiles=${#numfiles[@]}
-	echo "$numfiles PUZZLES" 
+	echo "$numfiles PUZZLES"
 
 	if [[ "$PROGRAM" == "sudoku-serial" ]]; then
 		echo "MODE: serial"
@@ -20,19 +113,72 @@ if [[ -n "$PROGRAM" ]]; then
 
 		echo "MODE: omp parallel"
 		echo "NUMBER OF THREADS: $NUM_THREADS"
+	elif [[ "$PROGRAM" == "sudoku-mpi" || "$PROGRAM" == "sudoku-hybrid" ]]; then
+		#MPIRUN may add the launcher's own options, e.g. a host file
+		export OMP_NUM_THREADS=${OMP_NUM_THREADS:-2}
+		RUN=(${MPIRUN:-mpirun} -x OMP_NUM_THREADS -np "$NUM_THREADS")
+
+		echo "MODE: mpi"
+		echo "NUMBER OF PROCESSES: $NUM_THREADS"
 	fi
 	printf "*******************************************\n\n"
 
 	COUNT=1
-	for filename in input/*.in
+	for filename in input/*.txt
 	do
 		echo "TEST: $COUNT"
 		echo "FILE: $filename "
 		COUNT=$((COUNT+1))
-		./"$PROGRAM" "$filename"
+		"${RUN[@]}" ./"$PROGRAM" "$filename"
 		echo "=========================================="
 	done
+
+	printf "\n*******************************************\n"
+	printf "\tRegression runs.\n"
+	printf "*******************************************\n\n"
+
+	#Default search, and the explicit stack search without the kernel
+	for filename in input/*.txt
+	do
+		regression "$filename"
+		regression "$filename" --kernel=off
+	done
+	regression input/16x16.txt --kernel=off --branch=first
+	regression input/36x36-hard.txt --engine=dlx
+
+	#Boards with two-word masks
+	regression input/81x81-hard.txt --kernel=off --branch=first
+	regression input/81x81-hard.txt --frontier=16
+
+	#Frontier expansion, deep and wide, and none at all
+	regression input/16x16-zeros.txt --frontier=64 --frontier-depth=4
+	regression input/36x36-hard.txt --frontier=16 --frontier-depth=2
+	regression input/9x9-nosol.txt --frontier=16
+	regression input/16x16.txt --frontier=0
+
+	#Batch mode, 1x1 boards have no kernel
+	for options in "" "--kernel=off" "--engine=dlx"
+	do
+		regression_batch input/batch/1x1.txt 3 $options
+		regression_batch input/batch/4x4.txt 14 $options
+		regression_batch input/batch/9x9.txt 4 $options
+		regression_batch input/batch/16x16.txt 2 $options
+	done
+
+	#Checkpoints after every slice, a run killed on its way and resumed,
+	#and a resume with no checkpoint written yet
+	rm -f "$CHECKPOINT"
+	regression input/36x36-hard.txt --checkpoint="$CHECKPOINT" --checkpoint-interval=0
+	report "$([[ -e "$CHECKPOINT" ]] && echo LEFT || echo REMOVED)" REMOVED "checkpoint removed once solved"
+	timeout 2 "${RUN[@]}" ./"$PROGRAM" input/16x16.txt --propagation=off --branch=first --checkpoint="$CHECKPOINT" --checkpoint-interval=0 > /dev/null 2>&1
+	regression input/16x16.txt --checkpoint="$CHECKPOINT" --resume
+	#the ranks of a killed mpirun may still be saving for a moment
+	regression input/9x9.txt --checkpoint="$CHECKPOINT.none" --resume
+	rm -f "$CHECKPOINT" "$CHECKPOINT.none" "$OUTPUT"
+
+	echo "=========================================="
+	echo "FAILED: $FAILED"
+	[[ $FAILED -eq 0 ]]
 else
 	echo "Error passing arguments: must pass program name as argument, e.g sudoku-serial ."
 fi
-
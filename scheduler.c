@@ -0,0 +1,258 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+
+#include "scheduler.h"
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static void * take(Deque * deque, int capacity, int bottom);
+
+
+/**
+ * Creates a scheduler with an empty deque for every worker.
+ *
+ * @param workers Number of worker threads.
+ * @param capacity Maximum number of nodes held by one deque.
+ * @return Returns the new scheduler.
+ */
+Scheduler * scheduler_create(int workers, int capacity){
+    Scheduler * scheduler = aligned_alloc(SCHEDULER_ALIGNMENT, sizeof(Scheduler));
+    scheduler->workers = workers;
+    scheduler->capacity = capacity;
+    scheduler->queued = 0;
+    scheduler->pending = 0;
+    scheduler->deques = aligned_alloc(SCHEDULER_ALIGNMENT, workers * sizeof(Deque));
+
+    int worker;
+    for (worker = 0; worker < workers; ++worker){
+        Deque * deque = &scheduler->deques[worker];
+        omp_init_lock(&deque->lock);
+        deque->top = 0;
+        deque->count = 0;
+        deque->seed = worker + 1;
+        deque->socket = 0;
+        deque->nodes = malloc(capacity * sizeof(void *));
+    }
+    return scheduler;
+}
+
+/**
+ * Pushes a node at the bottom of the deque of a worker, only called by the
+ * owner of the deque.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @param worker Index of the worker pushing the node.
+ * @param node Node to push.
+ * @return Returns zero if the deque is full and the node was not pushed.
+ */
+int scheduler_push(Scheduler * scheduler, int worker, void * node){
+    Deque * deque = &scheduler->deques[worker];
+    int pushed = 0;
+
+    // counted before it can be stolen, so it never looks searched too early
+    #pragma omp atomic
+    scheduler->pending++;
+    #pragma omp atomic
+    scheduler->queued++;
+
+    omp_set_lock(&deque->lock);
+    if (deque->count < scheduler->capacity){
+        deque->nodes[(deque->top + deque->count) % scheduler->capacity] = node;
+        // read without the lock by thieves looking for a victim
+        #pragma omp atomic write
+        deque->count = deque->count + 1;
+        pushed = 1;
+    }
+    omp_unset_lock(&deque->lock);
+
+    if (!pushed){
+        #pragma omp atomic
+        scheduler->queued--;
+        #pragma omp atomic
+        scheduler->pending--;
+    }
+    return pushed;
+}
+
+/**
+ * Pops the node at the bottom of the deque of a worker, the last one it
+ * pushed, only called by the owner of the deque.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @param worker Index of the worker popping the node.
+ * @return Returns the node, or NULL if the deque is empty.
+ */
+void * scheduler_pop(Scheduler * scheduler, int worker){
+    void * node = take(&scheduler->deques[worker], scheduler->capacity, 1);
+    if (node != NULL){
+        #pragma omp atomic
+        scheduler->queued--;
+    }
+    return node;
+}
+
+/**
+ * Records the socket a worker runs on, called by the worker before the
+ * search starts.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @param worker Index of the worker.
+ * @param socket Socket of the processor of the worker.
+ */
+void scheduler_place(Scheduler * scheduler, int worker, int socket){
+    scheduler->deques[worker].socket = socket;
+}
+
+/**
+ * Steals the node at the top of the deque of another worker, the oldest
+ * and shallowest one. Victims on the socket of the thief are tried first,
+ * so nodes only cross sockets when the socket has none left; on either
+ * pass victims are tried in order from a random one.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @param worker Index of the worker stealing.
+ * @return Returns the node, or NULL if every other deque is empty.
+ */
+void * scheduler_steal(Scheduler * scheduler, int worker){
+    Deque * own = &scheduler->deques[worker];
+    int first = rand_r(&own->seed) % scheduler->workers;
+
+    int pass, i;
+    for (pass = 0; pass < 2; ++pass){
+        for (i = 0; i < scheduler->workers; ++i){
+            int victim = (first + i) % scheduler->workers;
+            Deque * deque = &scheduler->deques[victim];
+            int count;
+            // skip empty deques without taking their lock
+            #pragma omp atomic read
+            count = deque->count;
+            if (victim == worker || count == 0 || (deque->socket == own->socket) != (pass == 0)){
+                continue;
+            }
+
+            void * node = take(deque, scheduler->capacity, 0);
+            if (node != NULL){
+                #pragma omp atomic
+                scheduler->queued--;
+                return node;
+            }
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Marks a node taken from the scheduler as searched. Any node split from
+ * it must be pushed before.
+ *
+ * @param scheduler Scheduler of the workers.
+ */
+void scheduler_done(Scheduler * scheduler){
+    #pragma omp atomic
+    scheduler->pending--;
+}
+
+/**
+ * Number of nodes waiting in the deques of every worker.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @return Returns the number of nodes queued.
+ */
+int scheduler_queued(Scheduler * scheduler){
+    int queued;
+    #pragma omp atomic read
+    queued = scheduler->queued;
+    return queued;
+}
+
+/**
+ * Checks if every node pushed was searched.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @return Returns non-zero if nothing is queued or being searched.
+ */
+int scheduler_finished(Scheduler * scheduler){
+    int pending;
+    #pragma omp atomic read
+    pending = scheduler->pending;
+    return pending == 0;
+}
+
+/**
+ * Number of nodes in the deque of a worker.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @param worker Index of the worker.
+ * @return Returns the number of nodes in the deque.
+ */
+int scheduler_size(Scheduler * scheduler, int worker){
+    int count;
+    #pragma omp atomic read
+    count = scheduler->deques[worker].count;
+    return count;
+}
+
+/**
+ * Node of the deque of a worker, left in the deque. Only meaningful while
+ * no worker pushes or takes nodes, as when every worker waits for a
+ * checkpoint to be written.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @param worker Index of the worker owning the deque.
+ * @param index Position of the node from the top of the deque, below scheduler_size.
+ * @return Returns the node.
+ */
+void * scheduler_peek(Scheduler * scheduler, int worker, int index){
+    Deque * deque = &scheduler->deques[worker];
+    omp_set_lock(&deque->lock);
+    void * node = deque->nodes[(deque->top + index) % scheduler->capacity];
+    omp_unset_lock(&deque->lock);
+    return node;
+}
+
+/**
+ * Free's a scheduler, the nodes left in the deques are not freed.
+ *
+ * @param scheduler Scheduler to free.
+ */
+void scheduler_free(Scheduler * scheduler){
+    if (scheduler != NULL) {
+        int worker;
+        for (worker = 0; worker < scheduler->workers; ++worker){
+            omp_destroy_lock(&scheduler->deques[worker].lock);
+            free(scheduler->deques[worker].nodes);
+        }
+        free(scheduler->deques);
+        free(scheduler);
+    }
+}
+
+/**
+ * Takes a node out of a deque.
+ *
+ * @param deque Deque to take the node from.
+ * @param capacity Maximum number of nodes held by the deque.
+ * @param bottom Non-zero to take the newest node, zero for the oldest.
+ * @return Returns the node, or NULL if the deque is empty.
+ */
+static void * take(Deque * deque, int capacity, int bottom){
+    void * node = NULL;
+
+    omp_set_lock(&deque->lock);
+    if (deque->count > 0){
+        if (bottom){
+            node = deque->nodes[(deque->top + deque->count - 1) % capacity];
+        } else {
+            node = deque->nodes[deque->top];
+            deque->top = (deque->top + 1) % capacity;
+        }
+        #pragma omp atomic write
+        deque->count = deque->count - 1;
+    }
+    omp_unset_lock(&deque->lock);
+    return node;
+}
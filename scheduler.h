@@ -0,0 +1,72 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <omp.h>
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// deques start on their own cache line so owners do not share one
+#define SCHEDULER_ALIGNMENT 64
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Search nodes owned by one worker, kept in a ring in the order they were
+ * pushed. The owner pushes and pops at the bottom, the newest and deepest
+ * node, thieves steal from the top, the oldest and shallowest one. Each
+ * deque has its own lock, there is no lock shared by every worker.
+ */
+struct Deque {
+    omp_lock_t lock;
+    int top;
+    int count;
+    // state of the random victim selection of the owner
+    unsigned int seed;
+    // socket the owner runs on, thieves on the same socket are tried first
+    int socket;
+    void ** nodes;
+} __attribute__((aligned(SCHEDULER_ALIGNMENT)));
+
+/**
+ * Work stealing scheduler, one deque per worker thread.
+ *
+ * A node is pending from the time it is pushed until its worker calls
+ * scheduler_done, the search is over when nothing is pending.
+ */
+struct Scheduler {
+    int workers;
+    int capacity;
+    struct Deque * deques;
+    // nodes in the deques, only read and changed atomically
+    int queued __attribute__((aligned(SCHEDULER_ALIGNMENT)));
+    // nodes in the deques or being searched, only read and changed atomically
+    int pending __attribute__((aligned(SCHEDULER_ALIGNMENT)));
+};
+
+typedef struct Deque Deque;
+typedef struct Scheduler Scheduler;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Scheduler * scheduler_create(int workers, int capacity);
+int scheduler_push(Scheduler * scheduler, int worker, void * node);
+void * scheduler_pop(Scheduler * scheduler, int worker);
+void scheduler_place(Scheduler * scheduler, int worker, int socket);
+void * scheduler_steal(Scheduler * scheduler, int worker);
+void scheduler_done(Scheduler * scheduler);
+int scheduler_queued(Scheduler * scheduler);
+int scheduler_finished(Scheduler * scheduler);
+int scheduler_size(Scheduler * scheduler, int worker);
+void * scheduler_peek(Scheduler * scheduler, int worker, int index);
+void scheduler_free(Scheduler * scheduler);
+
+#endif
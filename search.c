@@ -0,0 +1,192 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdlib.h>
+#include <string.h>
+
+#include "search.h"
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static int push_next(Search * search);
+
+
+/**
+ * Creates a search starting from the current constraint state. The state
+ * should already be propagated, the search only propagates its own choices.
+ *
+ * @param constraints Constraint state of the puzzle, modified by the search.
+ * @param trail Trail of the changes made to the constraint state.
+ * @param options Branching and propagation options.
+ * @return Returns the new search.
+ */
+Search * search_create(Constraints * constraints, Trail * trail, Options * options){
+    Search * search = malloc(sizeof(Search));
+    search->capacity = 0;
+    search->stack = NULL;
+    search_init(search, constraints, trail, options);
+    return search;
+}
+
+/**
+ * Restarts a search from the current constraint state, as search_create
+ * does, keeping the stack of the previous search when it is deep enough.
+ *
+ * @param search Search to restart.
+ * @param constraints Constraint state of the puzzle, modified by the search.
+ * @param trail Trail of the changes made to the constraint state.
+ * @param options Branching and propagation options.
+ */
+void search_init(Search * search, Constraints * constraints, Trail * trail, Options * options){
+    search->constraints = constraints;
+    search->trail = trail;
+    search->branching = options->branching;
+    search->propagation = options->propagation;
+    search->depth = 0;
+    if (search->capacity < constraints->open_count + 1){
+        search->capacity = constraints->open_count + 1;
+        search->stack = realloc(search->stack, search->capacity * sizeof(Frame));
+    }
+    search->states = 1;
+    search->backtracks = 0;
+    search->propagations = 0;
+    search->spawn = NULL;
+    search->data = NULL;
+    search->status = push_next(search) ? SEARCH_SUSPENDED : SEARCH_SOLVED;
+}
+
+/**
+ * Runs the search until it finds a solution, exhausts the tree or tries
+ * the given number of branches. Once solved the constraint state holds the
+ * solution; once exhausted it is back to the state the search started from.
+ *
+ * @param search Search to run.
+ * @param budget Maximum number of branches to try or hand to the spawn hook, 0 for no limit.
+ * @return Returns SEARCH_SOLVED, SEARCH_EXHAUSTED or SEARCH_SUSPENDED if the budget ran out.
+ */
+int search_run(Search * search, long budget){
+    Constraints * constraints = search->constraints;
+    Trail * trail = search->trail;
+    long tried = 0;
+
+    if (search->status != SEARCH_SUSPENDED){
+        return search->status;
+    }
+
+    while (search->depth > 0){
+        if (budget > 0 && tried >= budget){
+            return SEARCH_SUSPENDED;
+        }
+
+        // backtrack to the state the decision was taken on
+        Frame * frame = &search->stack[search->depth - 1];
+        constraints_undo(constraints, trail, frame->mark);
+        if (frame->candidates == 0){
+            search->depth--;
+            search->backtracks++;
+            continue;
+        }
+
+        int number = mask_first(frame->candidates);
+        frame->candidates = mask_drop_first(frame->candidates);
+        // a branch handed out counts as tried, a slice of the search stays a slice
+        tried++;
+        if (search->spawn != NULL && search->spawn(search, frame->cell, number, search->data)){
+            continue;
+        }
+
+        search->states++;
+        constraints_assign(constraints, trail, frame->cell / constraints->n,
+                           frame->cell % constraints->n, number);
+        if (search->propagation){
+            int open = constraints->open_count;
+            if (!constraints_propagate(constraints, trail)){
+                continue;
+            }
+            search->propagations += open - constraints->open_count;
+        }
+        if (!push_next(search)){
+            search->status = SEARCH_SOLVED;
+            return search->status;
+        }
+    }
+
+    search->status = SEARCH_EXHAUSTED;
+    return search->status;
+}
+
+/**
+ * Takes the next untried number of the shallowest decision out of a
+ * suspended search, the largest subtree it has not started, so another
+ * worker can search it. The search no longer tries that number.
+ *
+ * @param search Suspended search to split.
+ * @param min_open Empty cells the branch must leave for it to be taken out.
+ * @param copy Constraint state to fill with the state the decision was taken on.
+ * @param cell Cell reference of the branch taken out.
+ * @param number Number reference of the branch taken out.
+ * @return Returns the depth of the decision, or -1 if no branch was taken out.
+ */
+int search_split(Search * search, int min_open, Constraints * copy, int * cell, int * number){
+    if (search->status != SEARCH_SUSPENDED){
+        return -1;
+    }
+
+    int depth;
+    for (depth = 0; depth < search->depth; ++depth){
+        if (search->stack[depth].candidates != 0){
+            break;
+        }
+    }
+    // the shallowest branch is the largest one, deeper ones leave even fewer cells
+    if (depth == search->depth || search->stack[depth].open - 1 <= min_open){
+        return -1;
+    }
+
+    // undo the copy back to the decision, the trail itself is left as it is
+    Frame * frame = &search->stack[depth];
+    Trail view = *search->trail;
+    constraints_copy_to(copy, search->constraints);
+    constraints_undo(copy, &view, frame->mark);
+
+    *cell = frame->cell;
+    *number = mask_first(frame->candidates);
+    frame->candidates = mask_drop_first(frame->candidates);
+    return depth;
+}
+
+/**
+ * Free's a search, the constraint state and the trail are left untouched.
+ *
+ * @param search Search to free.
+ */
+void search_free(Search * search){
+    if (search != NULL) {
+        free(search->stack);
+        free(search);
+    }
+}
+
+/**
+ * Selects the next cell to branch on and pushes its decision.
+ *
+ * @param search Search to extend.
+ * @return Returns zero if there is no empty cell left, the puzzle is solved.
+ */
+static int push_next(Search * search){
+    Constraints * constraints = search->constraints;
+    int cell = search->branching == BRANCH_MRV ? constraints_select_cell(constraints)
+                                               : constraints_first_cell(constraints);
+    if (cell < 0){
+        return 0;
+    }
+
+    Frame * frame = &search->stack[search->depth++];
+    frame->cell = cell;
+    frame->mark = search->trail->count;
+    frame->open = constraints->open_count;
+    frame->candidates = constraints_candidates(constraints, cell / constraints->n, cell % constraints->n);
+    return 1;
+}
@@ -0,0 +1,73 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include "constraints.h"
+#include "options.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// outcomes of running a search
+#define SEARCH_EXHAUSTED 0
+#define SEARCH_SOLVED 1
+#define SEARCH_SUSPENDED 2
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * A decision of the search: the cell branched on, the numbers still to be
+ * tried in it and the trail position to undo to before trying the next one.
+ */
+struct Frame {
+    int cell;
+    int mark;
+    // empty cells when the decision was taken
+    int open;
+    Mask candidates;
+};
+
+/**
+ * Depth-first search over a constraint state driven by an explicit stack of
+ * decisions instead of recursion. The stack is allocated once, one frame per
+ * empty cell, so the depth is bounded up front. Between runs the whole search
+ * is described by the stack and the constraint state, so it can be suspended
+ * and resumed, split or saved.
+ */
+struct Search {
+    Constraints * constraints;
+    Trail * trail;
+    int branching;
+    int propagation;
+    int status;
+    int depth;
+    int capacity;
+    struct Frame * stack;
+    long states;
+    // decisions left with no number to try and cells filled by propagation
+    long backtracks;
+    long propagations;
+    // optional hook that may hand a (cell, number) branch to another worker
+    int (*spawn)(struct Search * search, int cell, int number, void * data);
+    void * data;
+};
+
+typedef struct Frame Frame;
+typedef struct Search Search;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+Search * search_create(Constraints * constraints, Trail * trail, Options * options);
+void search_init(Search * search, Constraints * constraints, Trail * trail, Options * options);
+int search_run(Search * search, long budget);
+int search_split(Search * search, int min_open, Constraints * copy, int * cell, int * number);
+void search_free(Search * search);
+
+#endif
@@ -0,0 +1,89 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <string.h>
+
+#include "stats.h"
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+static void print_counters(FILE * file, Stats * stats);
+
+
+/**
+ * Sets every counter to zero.
+ *
+ * @param stats Counters to clear.
+ */
+void stats_clear(Stats * stats){
+    memset(stats, 0, sizeof(Stats));
+}
+
+/**
+ * Adds the counters of a worker to a total.
+ *
+ * @param total Counters to add to.
+ * @param stats Counters of the worker.
+ */
+void stats_add(Stats * total, Stats * stats){
+    total->nodes += stats->nodes;
+    total->backtracks += stats->backtracks;
+    total->propagations += stats->propagations;
+    total->spawned += stats->spawned;
+    total->stolen += stats->stolen;
+    total->executed += stats->executed;
+    total->idle += stats->idle;
+}
+
+/**
+ * Prints the counters of every worker and their total as one JSON object.
+ * The imbalance is the nodes searched by the busiest worker over the mean,
+ * 1 when every worker searched as many.
+ *
+ * @param file File to print to.
+ * @param solver Name of the solver.
+ * @param workers Counters of every worker.
+ * @param count Number of workers.
+ * @param solved Non-zero if a solution was found.
+ * @param elapsed Seconds the solver took.
+ */
+void stats_print_json(FILE * file, char * solver, Stats * workers, int count, int solved, double elapsed){
+    Stats total;
+    long busiest = 0;
+    int worker;
+
+    stats_clear(&total);
+    for (worker = 0; worker < count; ++worker){
+        stats_add(&total, &workers[worker]);
+        if (workers[worker].nodes > busiest){
+            busiest = workers[worker].nodes;
+        }
+    }
+    double imbalance = total.nodes > 0 ? (double) busiest * count / total.nodes : 1.0;
+
+    fprintf(file, "{\"solver\": \"%s\", \"workers\": %d, \"solved\": %s, \"elapsed\": %f, \"imbalance\": %f,\n",
+            solver, count, solved ? "true" : "false", elapsed, imbalance);
+    fprintf(file, " \"total\": ");
+    print_counters(file, &total);
+    fprintf(file, ",\n \"per_worker\": [");
+    for (worker = 0; worker < count; ++worker){
+        fprintf(file, worker > 0 ? ",\n  " : "\n  ");
+        print_counters(file, &workers[worker]);
+    }
+    fprintf(file, "\n ]}\n");
+}
+
+/**
+ * Prints the counters of one worker as a JSON object.
+ *
+ * @param file File to print to.
+ * @param stats Counters to print.
+ */
+static void print_counters(FILE * file, Stats * stats){
+    fprintf(file, "{\"nodes\": %ld, \"backtracks\": %ld, \"propagations\": %ld, "
+            "\"spawned\": %ld, \"stolen\": %ld, \"executed\": %ld, \"idle\": %f}",
+            stats->nodes, stats->backtracks, stats->propagations,
+            stats->spawned, stats->stolen, stats->executed, stats->idle);
+}
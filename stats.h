@@ -0,0 +1,49 @@
+#ifndef STATS_H
+#define STATS_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdio.h>
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// counters of every worker fill their own cache line
+#define STATS_ALIGNMENT 64
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Search counters of one worker, a thread or a rank. Only the worker
+ * changes its own counters, they are added up once the search is over.
+ */
+struct Stats {
+    // states searched, a number placed by a decision of the search
+    long nodes;
+    // decisions left with no number to try
+    long backtracks;
+    // cells filled by propagation on the branches left consistent
+    long propagations;
+    // work items created, taken from another worker and searched
+    long spawned;
+    long stolen;
+    long executed;
+    // seconds spent waiting for work
+    double idle;
+} __attribute__((aligned(STATS_ALIGNMENT)));
+
+typedef struct Stats Stats;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+void stats_clear(Stats * stats);
+void stats_add(Stats * total, Stats * stats);
+void stats_print_json(FILE * file, char * solver, Stats * workers, int count, int solved, double elapsed);
+
+#endif
@@ -6,20 +6,57 @@
 #include <math.h>
 
 #include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "board.h"
+#include "checkpoint.h"
+#include "constraints.h"
+#include "dlx.h"
+#include "frontier.h"
+#include "kernel.h"
+#include "options.h"
+#include "pool.h"
+#include "puzzles.h"
+#include "search.h"
+#include "stats.h"
+#include "wire.h"
 
 struct Puzzle {
         int root_n;
         int depth;
         int n;
-        int * matrix;
+        Board * board;
+        Constraints * constraints;
+        Trail * trail;
 };
 
 typedef struct Puzzle Puzzle;
 
+/**
+ * Work item of the master's pool. Nodes are recycled through a pool and
+ * keep their board, so only the cells are copied in and out.
+ */
 struct Node {
-    int * matrix;
-    int n;
+    // first, it holds the free list link while the node is in the pool
     struct Node * next;
+    Board * board;
+    // decisions taken from the given puzzle
+    int depth;
+    // empty cells left and log2 of the product of their candidate counts, the size of the subtree
+    int open;
+    double estimate;
+};
+
+/**
+ * Work items of the master, a binary max-heap on the estimated size of
+ * their subtrees, so the largest one is handed out first.
+ */
+struct Queue {
+    struct Node ** items;
+    int count;
+    int capacity;
 };
 
 typedef int bool;
@@ -27,6 +64,53 @@ typedef int bool;
 #define false 0
 #define true 1
 
+/**
+ * State of a rank of the peer to peer search: its own stack of work items
+ * and its part of the Dijkstra-Safra termination detection. Work sent to a
+ * thief counts up, work received counts down and blackens the rank; the
+ * token adds up the counts of every passive rank and is white only if no
+ * rank received work since it last passed.
+ */
+struct Peer {
+    int rank;
+    int nprocs;
+    struct Node * work;
+    // work items stolen and solutions are decoded here
+    Board * inbox;
+    // a steal request is waiting for its answer, and when the next one may be sent
+    bool stealing;
+    double retry;
+    double backoff;
+    int counter;
+    int color;
+    // token kept until the rank is passive, rank 0 knows if one is going round
+    bool holding;
+    bool round;
+    int token[2];
+    bool solved;
+    double secs;
+};
+
+/**
+ * Work items a slave was sent and has not searched yet, and what it owes
+ * the master: the work items finished or given back since its last report
+ * and the seconds it spent on them. The report goes with the next request
+ * for work, which leaves as the last work item of the batch starts.
+ */
+struct Batch {
+    struct Node * items;
+    int count;
+    int done;
+    double spent;
+    // a request for the next batch is on its way or waiting on the master
+    bool asked;
+    // batches received so far, and the work item being searched, NULL between two
+    int received;
+    Puzzle * current;
+    // work items of a batch are decoded here
+    Board * inbox;
+};
+
 // Get the size of elements on an array
 #define NELEMS(x)  (sizeof(x) / sizeof((x)[0]))
 
@@ -35,32 +119,164 @@ typedef int bool;
 #define NO_SOLUTION_FOUND 345
 #define SOLUTION_FOUND 456
 #define STOP_WORK 567
+#define SPLIT_WORK 678
+#define DONATE_WORK 789
+#define WORK_STOPPED 890
+#define STEAL_REQUEST 901
+#define WORK_REPLY 912
+#define TOKEN 923
+#define TERMINATE 934
+#define CHECKPOINT 945
+#define CHECKPOINT_ITEMS 956
+
+// colors of the ranks and of the termination token
+#define WHITE 0
+#define BLACK 1
+
+// first and longest wait before a rank whose steal was denied tries again, in seconds
+#define STEAL_BACKOFF 0.0001
+#define STEAL_BACKOFF_MAX 0.01
+// wait between two checks for messages of an idle rank, in microseconds
+#define PEER_NAP 50
+
+// seconds of search the master sizes a batch of work items to, and most work items in a batch
+#define BATCH_SECONDS 0.005
+#define BATCH_MAX 16
+
+// work items the master splits its queue into per slave, at most
+#define QUEUE_ITEMS_PER_SLAVE 8
+
+// the master hands a slave at most its share of the puzzles of a batch left, split this many
+// ways, and at most this many puzzles at once
+#define PUZZLES_SHARE 4
+#define PUZZLES_CHUNK_MAX 256
+// chunks of puzzles every slave holds at once, the next one comes while it solves one
+#define PUZZLES_IN_FLIGHT 2
+
+// branches a slave searches between two checks for messages
+#define SPLIT_INTERVAL 64
+// calls of the stop hook of the kernel, Dancing Links and the scans between two checks for messages
+#define STOP_POLL_CALLS 16
 
 #define WORLD MPI_COMM_WORLD
 
 
+// set by the thread of the rank that talks MPI, read by every thread of the hybrid build,
+// only through order_stop and stop_ordered
 static bool ORDER_STOP_WORKING = false;
+static Options _options_;
+// nodes of the master's work pool
+static Pool * _nodes_ = NULL;
+// search reused for every work item of a slave
+static Search * _search_ = NULL;
+// constraint state of the branches a slave splits off its search
+static Constraints * _donation_ = NULL;
+// rank of the peer to peer search
+static struct Peer _peer_;
+// search counters of the rank
+static Stats _stats_;
+// puzzle every rank was given, work items are sent relative to it
+static Board * _given_ = NULL;
+// messages of work items, batches of them and solutions are written and received here
+static uint8_t * _wire_ = NULL;
+// work items of a slave, only the thread that talks MPI touches them
+static struct Batch _batch_;
+// work items of the last checkpoint on the master, NULL without checkpoints
+static Checkpoint * _checkpoint_ = NULL;
+// work a slave saves for a checkpoint, created on its first one
+static Checkpoint * _saved_ = NULL;
+// buffers of the puzzles of a batch a thread solves, created on its first one
+static PuzzlesScratch * _scratch_ = NULL;
+
+#ifdef _OPENMP
+/**
+ * Threads of a rank of the hybrid build searching one work item together.
+ * The branches of the work item are shared on a stack of the rank, taken
+ * under a lock; a thread whose search runs while other threads wait splits
+ * its shallowest untried branch onto the stack. Only the main thread of
+ * the rank talks MPI.
+ */
+struct Team {
+    struct Node * work;
+    Pool * nodes;
+    // branches on the stack and threads searching one
+    int queued;
+    int busy;
+    // set by the first thread to find a solution, which copies it out
+    int found;
+    // counters of the other threads, added to the rank's once the work item is over
+    Stats stats;
+};
+
+static struct Team _team_;
+// puzzle every thread searches the branches it takes on
+static Puzzle * _mine_ = NULL;
+#pragma omp threadprivate(_search_, _donation_, _stats_, _mine_, _scratch_)
+#endif
 
 
-void init(struct Node * head);
-void display(struct Node * head);
 bool is_empty(struct Node * head);
-struct Node * push(struct Node * head, int n, int * matrix);
-struct Node * pop(struct Node * head, int * n, int ** matrix);
+struct Node * push(struct Node * head, Board * board, int depth);
+struct Node * push_cells(struct Node * head, Pool * nodes, uint8_t * cells, int root_n, int depth);
+void queue_push(struct Queue * queue, struct Node * node);
+struct Node * queue_pop(struct Queue * queue);
+bool enqueue(struct Queue * queue, Puzzle * puzzle, int depth);
+bool refine(struct Queue * queue, Puzzle * puzzle, Board * parent, int wanted, int limit);
+bool dominates(struct Queue * queue);
+int batch_size(double pace, int queued, int slaves);
+void send_batch(struct Queue * queue, int count, int rank);
+void receive_batch(MPI_Status * status);
+void report_done(int tag);
+void begin_checkpoint(struct Queue * queue, int * batches, bool * saving, int nprocs);
+void save_work(Search * search);
+struct Node * pop(struct Node * head, struct Node ** node);
+void release_node(void * block);
 void print_puzzle(Puzzle * puzzle);
 bool check_grid(Puzzle * puzzle, int row, int column, int number);
 bool check_column(Puzzle * puzzle, int column, int number);
 bool check_row(Puzzle * puzzle, int row, int number);
 bool is_valid(Puzzle * puzzle, int row, int column, int number);
 bool find_empty(Puzzle * puzzle, int * row, int * column);
+bool select_cell(Puzzle * puzzle, int * row, int * column);
+bool load_constraints(Puzzle * puzzle);
+void store_values(Puzzle * puzzle);
 bool solve(Puzzle * puzzle);
+bool solve_scan(Puzzle * puzzle);
+bool solve_dlx(Puzzle * puzzle);
+bool donate(Search * search, Puzzle * puzzle, int rank, int tag);
+void poll_messages(Search * search, Puzzle * puzzle);
+int stop_requested(void * data);
+int split_cutoff(Puzzle * puzzle);
+Board * broadcast_puzzle(int rank);
+void send_cells(uint8_t * cells, int depth, int rank, int tag);
+bool receive_cells(MPI_Status * status, uint8_t * cells, int * depth);
 Puzzle * copy_puzzle(Puzzle * puzzle);
-int * copy_matrix(int n, int * matrix);
 void cleanPuzzle(Puzzle * puzzle);
-void on_solution_found(int size, int * matrix, double secs);
-void debug_matrix(int size, int * matrix);
-void master(int argc, char *argv[]);
+void on_solution_found(Board * board, double secs);
+bool solve_item(Puzzle * puzzle);
+bool stopping();
+bool stop_ordered();
+void order_stop();
+bool talks_mpi();
+void free_buffers();
+#ifdef _OPENMP
+bool solve_team(Puzzle * puzzle);
+void share_work(Search * search, Puzzle * puzzle);
+#endif
+void report_stats(bool solved, double secs);
+void master();
 void slave();
+void peer();
+void serve(Search * search, Puzzle * puzzle, MPI_Status * status);
+void serve_pending(Search * search, Puzzle * puzzle);
+void pass_token();
+void peer_solved(Puzzle * puzzle);
+void peer_terminate(Board * solution);
+void drain();
+void master_batch();
+void slave_batch();
+int send_puzzles(Puzzles * puzzles, int first, int slaves, int rank, uint8_t * message, MPI_Request * request);
+void solve_puzzles(Puzzles * puzzles);
 
 /**
  * Parallel Sudoku Solver using MPI
@@ -72,21 +288,33 @@ void slave();
 int main(int argc, char *argv[]){
 
     // Check command line arguments
-     if (argc != 2){
-        printf("ERROR: Invalid number of arguments arguments.\n");
+    if (!options_parse(&_options_, argc, argv)){
         exit(EXIT_FAILURE);
     }
     int rank;
 
-    // Initialize MPI
+    // Initialize MPI, only the main thread of a rank of the hybrid build calls it
+#ifdef _OPENMP
+    int provided;
+    MPI_Init_thread (&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+#else
     MPI_Init (&argc, &argv);
+#endif
     MPI_Comm_rank (WORLD, &rank);
 
     // Wait for all processes to init
     MPI_Barrier (WORLD);
 
-    if(rank == 0) {
-        master(argc, argv);
+    if(_options_.batch) {
+        if(rank == 0) {
+            master_batch();
+        } else {
+            slave_batch();
+        }
+    } else if(_options_.schedule == SCHEDULE_STEAL) {
+        peer();
+    } else if(rank == 0) {
+        master();
     } else {
         slave();
     }
@@ -98,437 +326,2057 @@ int main(int argc, char *argv[]){
     return EXIT_SUCCESS;
 }
 
-void master(int argc, char *argv[]) {
+void master() {
 
-    struct Node * work_pool = NULL;
-    init(work_pool);
+    struct Queue queue = {NULL, 0, 0};
 
     // Start counter
     double secs = - MPI_Wtime();
     int nprocs;
     MPI_Comm_size (WORLD, &nprocs);
-    FILE * file_input;
-    FILE * file_output;
-
-    char * filename;
-    filename = argv[1];
-
-    // Open file in read mode
-    if ((file_input = fopen(filename,"r")) == NULL){
-        printf("ERROR: Could not open file %s\n",filename);
-        fflush(stdout);
-        MPI_Finalize();
-        exit(EXIT_FAILURE);
-    }
 
-    // Number of rows and columns
-    int n;
-    // Square root of n
-    int root_n;
-    // Read first line from the file to get n
-    fscanf(file_input, "%d\n", &root_n);
-    n = root_n * root_n;
+    // Read the board from the file and give it to every slave
+    Board * board = broadcast_puzzle(0);
 
     // ======================================
     /** Initialize puzzle data structure */
     Puzzle * puzzle = malloc(sizeof(Puzzle));
-    puzzle->n = n;
-    puzzle->root_n = root_n;
+    puzzle->n = board->n;
+    puzzle->root_n = board->root_n;
     puzzle->depth = 1;
-    puzzle->matrix = (int*) malloc(n * n * sizeof(int));
-
-    // Read matrix from the file
-    int cursor;
-    int row = 0, col = 0, i, j;
-    for (i = 0; i < n; ++i){
-            for (j = 0; j < n; ++j){
-                    fscanf(file_input, "%d", &puzzle->matrix[i * puzzle->n + j]);
-            }
-            fscanf(file_input, "\n");
-    }
+    puzzle->board = board;
+    puzzle->constraints = NULL;
+    puzzle->trail = NULL;
     // ======================================
-    // Close file
-    fclose(file_input);
 
 
-
-
-    //Add candidates to a pool of tasks.
-    int r, c;
-    if(find_empty(puzzle, &r, &c)){
-        int num;
-        for(num = 1; num <= puzzle->n; num++){
-            if(is_valid(puzzle, r, c, num)){
-        int * mat = copy_matrix(puzzle->n, puzzle->matrix);
-        mat[r * puzzle->n + c] = num;
-                work_pool = push(work_pool, puzzle->n, mat);
+    // the frontier of the puzzle fills the queue, split further until every slave gets a work item
+    _nodes_ = pool_create(sizeof(struct Node), release_node);
+    int root_n = puzzle->root_n;
+    int limit = QUEUE_ITEMS_PER_SLAVE * (nprocs - 1);
+    // cells of the work item the master splits
+    Board * parent = board_create(root_n);
+    int iter;
+    // the work items of a checkpoint of the puzzle take the place of its frontier on --resume
+    bool resumed = false, exit = false;
+    if (_options_.checkpoint != NULL && _options_.engine == ENGINE_BACKTRACK && constraints_supported(puzzle->n)){
+        _checkpoint_ = checkpoint_create(_given_);
+        int read = _options_.resume ? checkpoint_read(_checkpoint_, _options_.checkpoint) : CHECKPOINT_MISSING;
+        if (read == CHECKPOINT_INVALID){
+            printf("ERROR: Could not resume from checkpoint %s\n", _options_.checkpoint);
+            fflush(stdout);
+            MPI_Abort(WORLD, EXIT_FAILURE);
+        }
+        resumed = read == CHECKPOINT_READ;
+    }
+    if (resumed){
+        size_t offset = 0;
+        int depth;
+        while (!exit && checkpoint_next(_checkpoint_, &offset, puzzle->board->cells, &depth)){
+            exit = enqueue(&queue, puzzle, depth);
+            _stats_.spawned++;
         }
+    } else {
+        Frontier * frontier = frontier_expand(board, &_options_, nprocs - 1);
+        exit = frontier->solved;
+        if (exit){
+            memcpy(puzzle->board->cells, frontier->solution, puzzle->n * puzzle->n);
+        }
+        for (iter = 0; iter < frontier->count && !exit; iter++){
+            memcpy(puzzle->board->cells, frontier_cells(frontier, iter), puzzle->n * puzzle->n);
+            exit = enqueue(&queue, puzzle, frontier->depths[iter]);
+            _stats_.spawned++;
         }
+        frontier_free(frontier);
+    }
+    exit = exit || refine(&queue, puzzle, parent, nprocs - 1, limit);
+    bool solved = exit;
+    if (solved){
+        secs += MPI_Wtime();
+        on_solution_found(puzzle->board, secs);
     }
 
     MPI_Status status;
     MPI_Status status2;
-    int size;
-    bool exit = false;
+    int size, depth, source;
+    double report[2];
+
+    // work items every slave was sent and did not report yet, whether it asked for more
+    // and whether it was asked to split its work item
+    int outstanding[nprocs];
+    bool asking[nprocs];
+    bool splitting[nprocs];
+    // slaves that had nothing to split off their current work item
+    bool barren[nprocs];
+    // seconds a work item takes every slave, 0 until it reported one
+    double pace[nprocs];
+    // batches sent to every slave, the slaves the checkpoint being written still waits for,
+    // how many of them and when the next checkpoint is due
+    int batches[nprocs];
+    bool saving[nprocs];
+    int replies = 0;
+    double next_checkpoint = MPI_Wtime() + _options_.checkpoint_interval;
+
+    // Initialize available processes status, busy until they ask for work
+    for(iter = 1; iter < nprocs; iter++){
+        outstanding[iter] = 0;
+        asking[iter] = false;
+        splitting[iter] = false;
+        barren[iter] = true;
+        pace[iter] = 0;
+        batches[iter] = 0;
+        saving[iter] = false;
+    }
 
-    bool procs[nprocs];
-    // Number of active slaves
-    int procs_count = nprocs - 1;
 
-    // Initialize available processes status
-    int iter;
-    for(iter = 1; i < nprocs; i++)
-    procs[iter] = true;
+    while(!exit){
 
+    // the largest work items are split until every slave asking can get one
+    int ready = 0;
+    for(iter = 1; iter < nprocs; iter++){
+        ready += asking[iter];
+    }
+    if(refine(&queue, puzzle, parent, ready, limit)){
+        secs += MPI_Wtime();
+        exit = true;
+        solved = true;
+        on_solution_found(puzzle->board, secs);
+        break;
+    }
 
-    while(!exit){
+    // hand a batch of work items out to every slave asking for one, largest first
+    for(iter = 1; iter < nprocs && queue.count > 0; iter++){
+        if(asking[iter]){
+            int count = batch_size(pace[iter], queue.count, nprocs - 1);
+            send_batch(&queue, count, iter);
+            batches[iter]++;
+            outstanding[iter] += count;
+            asking[iter] = false;
+            barren[iter] = false;
+        }
+    }
+
+    // a slave that has not asked yet is busy, one that asked ahead still searches its last work item
+    int busy = 0, waiting = 0, asked = 0;
+    for(iter = 1; iter < nprocs; iter++){
+        busy += !asking[iter] || outstanding[iter] > 0;
+        waiting += asking[iter] && outstanding[iter] == 0;
+        asked += splitting[iter];
+    }
 
-    if(procs_count == 0 && is_empty(work_pool)){
+    if(busy == 0 && queue.count == 0){
         secs += MPI_Wtime();
         exit = true;
-        printf("No solution\n");
-        //printf("Elapsed time: %12.6f (s)\n", secs);
+        if (!_options_.time_only_flag) {
+            printf("No solution\n");
+        }
+        if (_options_.time_flag) {
+            printf("Peak of %d work items in the pool.\n", _nodes_->peak);
+        }
+        if (_options_.time_flag || _options_.time_only_flag) {
+            printf("Elapsed time: %f (s)\n", secs);
+        }
         fflush(stdout);
+        // every slave is waiting, nothing left to search
+        break;
     }
 
-    // Block until receive that a message as been sent.
-    MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, WORLD ,&status);
+    // the pool ran dry, busy slaves are asked to split their work item for the ones waiting
+    for(iter = 1; iter < nprocs && asked < waiting; iter++){
+        if(outstanding[iter] > 0 && !splitting[iter] && !barren[iter]){
+            MPI_Send(0, 0, MPI_INT, iter, SPLIT_WORK, WORLD);
+            splitting[iter] = true;
+            asked++;
+        }
+    }
 
-    // Slave is availave to do some work.
-    if(status.MPI_TAG == ASK_FOR_WORK){
-        MPI_Recv(0, 0, MPI_INT, MPI_ANY_SOURCE, ASK_FOR_WORK, WORLD, &status2);
+    // Block until receive that a message as been sent, with checkpoints the clock is
+    // looked at meanwhile, as slaves searching long work items send nothing.
+    _stats_.idle -= MPI_Wtime();
+    if(_checkpoint_ == NULL){
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, WORLD ,&status);
+    } else {
+        int flag = false;
+        while(!flag){
+            if(replies == 0 && nprocs > 1 && MPI_Wtime() >= next_checkpoint){
+                begin_checkpoint(&queue, batches, saving, nprocs);
+                replies = nprocs - 1;
+            }
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, WORLD, &flag, &status);
+            if(!flag){
+                usleep(PEER_NAP);
+            }
+        }
+    }
+    _stats_.idle += MPI_Wtime();
+
+    // Slave is availave to do some work, the work items it finished come with the request
+    // or alone when it ran out of them before the next batch came.
+    if(status.MPI_TAG == ASK_FOR_WORK || status.MPI_TAG == NO_SOLUTION_FOUND){
+        source = status.MPI_SOURCE;
+        MPI_Recv(report, 2, MPI_DOUBLE, source, status.MPI_TAG, WORLD, &status2);
+        outstanding[source] -= report[0];
+        if(report[0] > 0){
+            double item = report[1] / report[0];
+            pace[source] = pace[source] > 0 ? (pace[source] + item) / 2 : item;
+            barren[source] = false;
+        }
+        asking[source] = asking[source] || status.MPI_TAG == ASK_FOR_WORK;
 
-        // Check if there is any work to be done.
-        if(!is_empty(work_pool)){
-            int nsize;
-            int * matrix;
-            work_pool = pop(work_pool, &nsize, &matrix);
-            MPI_Send(matrix, nsize * nsize, MPI_INT, status.MPI_SOURCE, START_WORK, WORLD );
-            procs[status.MPI_SOURCE] = true;
+    } else if (status.MPI_TAG == DONATE_WORK){
+        // an answer to a split, with the cells of the branch or empty if there was none
+        splitting[status.MPI_SOURCE] = false;
+        if(!receive_cells(&status, puzzle->board->cells, &depth)){
+            barren[status.MPI_SOURCE] = true;
         } else {
-            // Terminate the process
-            MPI_Send(0, 0, MPI_INT, status.MPI_SOURCE, STOP_WORK, WORLD);
-            procs[status.MPI_SOURCE] = false;
-            procs_count--;
+            if(saving[status.MPI_SOURCE]){
+                // given away before the slave saved its work, so it is not part of it
+                checkpoint_add(_checkpoint_, puzzle->board->cells, depth);
+            }
+            if(enqueue(&queue, puzzle, depth)){
+                // propagation alone solved the branch
+                secs += MPI_Wtime();
+                exit = true;
+                solved = true;
+                on_solution_found(puzzle->board, secs);
+            }
+        }
+
+    } else if (status.MPI_TAG == CHECKPOINT_ITEMS){
+        // the work of a slave, the checkpoint is written once every slave sent its own
+        MPI_Get_count(&status, MPI_BYTE, &size);
+        uint8_t * items = malloc(size);
+        MPI_Recv(items, size, MPI_BYTE, status.MPI_SOURCE, CHECKPOINT_ITEMS, WORLD, &status2);
+        if(!checkpoint_append(_checkpoint_, items, size)){
+            printf("ERROR: Malformed message from rank %d\n", status.MPI_SOURCE);
+            fflush(stdout);
+            MPI_Abort(WORLD, EXIT_FAILURE);
+        }
+        free(items);
+        saving[status.MPI_SOURCE] = false;
+        if(--replies == 0){
+            if(!checkpoint_write(_checkpoint_, _options_.checkpoint)){
+                printf("WARNING: Could not write checkpoint %s\n", _options_.checkpoint);
+                fflush(stdout);
+            }
+            next_checkpoint = MPI_Wtime() + _options_.checkpoint_interval;
         }
 
     } else if (status.MPI_TAG == SOLUTION_FOUND){
         secs += MPI_Wtime();
 
-        MPI_Get_count(&status, MPI_INT, &size);
-        int * matrix_solution = malloc(size * sizeof(int));
-        int n = (int) sqrt((double) size);
-
-        MPI_Recv(matrix_solution, size, MPI_INT, MPI_ANY_SOURCE, SOLUTION_FOUND, WORLD ,&status);
+        Board * solution = board_create(root_n);
+        receive_cells(&status, solution->cells, NULL);
         exit = true;
+        solved = true;
 
-        on_solution_found(n, matrix_solution, secs);
+        on_solution_found(solution, secs);
+        board_free(solution);
+    }
+    }
 
-        int i;
-        for(i = 1; i < nprocs; i++){
-            if(procs[i]){
-                MPI_Send(0, 0, MPI_INT, i,  STOP_WORK, WORLD);
-                procs[i] = false;
-                procs_count--;
-            }
+    // every slave is stopped, what they sent before they stopped is received and dropped
+    for(iter = 1; iter < nprocs; iter++){
+        MPI_Send(0, 0, MPI_INT, iter, STOP_WORK, WORLD);
+    }
+    int running = nprocs - 1;
+    while(running > 0){
+        MPI_Probe(MPI_ANY_SOURCE, MPI_ANY_TAG, WORLD, &status);
+        MPI_Get_count(&status, MPI_BYTE, &size);
+        // the work a slave saved for a checkpoint may not fit the buffer of the messages
+        uint8_t * buffer = status.MPI_TAG == CHECKPOINT_ITEMS ? malloc(size) : _wire_;
+        MPI_Recv(buffer, size, MPI_BYTE, status.MPI_SOURCE, status.MPI_TAG, WORLD, &status2);
+        if(buffer != _wire_){
+            free(buffer);
         }
-        free(matrix_solution);
+        running -= status.MPI_TAG == WORK_STOPPED;
+    }
+    board_free(parent);
+    cleanPuzzle(puzzle);
 
-    } else if (status.MPI_TAG == NO_SOLUTION_FOUND){
-         MPI_Recv(0,0,MPI_INT, MPI_ANY_SOURCE, NO_SOLUTION_FOUND, WORLD, &status2);
+    if (_options_.stats == STATS_JSON) {
+        report_stats(solved, secs);
+    }
 
-        }
+    if (_checkpoint_ != NULL){
+        // nothing is left to resume
+        remove(_options_.checkpoint);
+        checkpoint_free(_checkpoint_);
     }
+
+    // the work items left after a solution go back with the pool
+    free(queue.items);
+    pool_free(_nodes_);
+    board_free(_given_);
+    free(_wire_);
 }
 
 void slave() {
-    int rank, size;
+    int rank;
     bool stopped = false;
     MPI_Status status , status2;
     MPI_Comm_rank(WORLD, &rank);
 
-    do{
-        //Request master for a job
-        MPI_Send(0, 0, MPI_INT, 0, ASK_FOR_WORK, WORLD);
-
-    MPI_Probe(0, MPI_ANY_TAG, WORLD, &status);
+    // the puzzle and its buffers are reused by every work item
+    Puzzle * puzzle = malloc(sizeof(Puzzle));
+    puzzle->board = broadcast_puzzle(rank);
+    puzzle->n = puzzle->board->n;
+    puzzle->root_n = puzzle->board->root_n;
+    puzzle->constraints = NULL;
+    puzzle->trail = NULL;
+
+    _nodes_ = pool_create(sizeof(struct Node), release_node);
+    _batch_.items = NULL;
+    _batch_.count = 0;
+    _batch_.done = 0;
+    _batch_.spent = 0;
+    _batch_.asked = false;
+    _batch_.received = 0;
+    _batch_.current = NULL;
+    _batch_.inbox = board_create(puzzle->root_n);
 
-        if(status.MPI_TAG == START_WORK){
-            int size;
-            MPI_Get_count(&status, MPI_INT, &size);
-            int n = (int) sqrt((double) size);
-            int * partial_matrix = malloc(size * sizeof(int));
+    do{
+        // the next batch is asked for as the last work item starts, so it comes while that one is searched
+        if(!_batch_.asked && _batch_.count <= 1 && !stop_ordered()){
+            report_done(ASK_FOR_WORK);
+            _batch_.asked = true;
+        }
 
-            MPI_Recv(partial_matrix, size, MPI_INT, 0, START_WORK, WORLD, &status2);
+        if(_batch_.count > 0 && !stop_ordered()){
+            struct Node * node;
+            _batch_.items = pop(_batch_.items, &node);
+            _batch_.count--;
+            memcpy(puzzle->board->cells, node->board->cells, puzzle->n * puzzle->n);
+            puzzle->depth = node->depth;
+            pool_put(_nodes_, node);
 
             //Solve the puzzle
-            Puzzle * puzzle = malloc(sizeof(Puzzle));
-            puzzle->n = n;
-            puzzle->root_n = (int) sqrt((double) n);
-            puzzle->depth = 1;
-            puzzle->matrix = partial_matrix;
-
-            if(solve(puzzle)){
-                MPI_Send(puzzle->matrix, puzzle->n * puzzle->n, MPI_INT, 0, SOLUTION_FOUND, WORLD);
+            double secs = - MPI_Wtime();
+            _stats_.executed++;
+            _batch_.current = puzzle;
+            bool solved = load_constraints(puzzle);
+            if (solved){
+                solved = solve_item(puzzle);
+            }
+            _batch_.current = NULL;
+
+            if(solved){
+                // nothing else is searched or reported, the master stops the slave
+                send_cells(puzzle->board->cells, puzzle->depth, 0, SOLUTION_FOUND);
+                order_stop();
             } else {
-                MPI_Send(0, 0, MPI_INT, 0, NO_SOLUTION_FOUND, WORLD);
+                _batch_.done++;
+                _batch_.spent += secs + MPI_Wtime();
             }
+            continue;
+        }
+
+        // out of work items before the next batch came, the master learns the slave waits
+        if(_batch_.done > 0 && !stop_ordered()){
+            report_done(NO_SOLUTION_FOUND);
+        }
 
-            cleanPuzzle(puzzle);
+        _stats_.idle -= MPI_Wtime();
+        MPI_Probe(0, MPI_ANY_TAG, WORLD, &status);
+        _stats_.idle += MPI_Wtime();
+
+        if(status.MPI_TAG == SPLIT_WORK){
+            // a split asked for as the last work item ended finds nothing to give
+            MPI_Recv(0, 0, MPI_INT, 0, SPLIT_WORK, WORLD, &status2);
+            MPI_Send(0, 0, MPI_BYTE, 0, DONATE_WORK, WORLD);
+
+        } else if(status.MPI_TAG == START_WORK){
+            receive_batch(&status);
+            _batch_.asked = false;
+
+        } else if(status.MPI_TAG == CHECKPOINT){
+            save_work(NULL);
 
         } else if (status.MPI_TAG == STOP_WORK){
             MPI_Recv(0,0, MPI_INT, 0, STOP_WORK, WORLD, &status2);
             stopped = true;
-        ORDER_STOP_WORKING = true;
-        return;
+        order_stop();
         }
 
     } while (!stopped);
+    // the last message of the slave, the master drains everything up to it
+    MPI_Send(0, 0, MPI_INT, 0, WORK_STOPPED, WORLD);
 
-}
+    if (_options_.stats == STATS_JSON) {
+        report_stats(false, 0);
+    }
 
+    // the work items left after a solution go back with the pool
+    pool_free(_nodes_);
+    board_free(_batch_.inbox);
+    checkpoint_free(_saved_);
+    cleanPuzzle(puzzle);
+    free_buffers();
+    board_free(_given_);
+    free(_wire_);
+}
 
 /**
- * Attemp to solve the sudoku puzzle using backtracking.
- *
- * @param puzzle Sudoku puzzle data structure.
- * @return Returns true if the sudoku has a solution.
+ * Rank of the peer to peer search. Every rank searches: each one keeps the
+ * subproblems of the frontier whose index falls on it, and a rank left
+ * without work asks a random rank for some. The rank asked gives away a
+ * work item it has not started, or splits the largest untried branch off
+ * its search, or answers with nothing. Rank 0 sends a Dijkstra-Safra token
+ * round the ranks whenever it is passive, and stops every rank once a round
+ * shows none of them has work or work in flight, or once a solution is found.
  */
-bool solve(Puzzle * puzzle){
-    if(ORDER_STOP_WORKING){
-    return false;
+void peer() {
+    struct Peer * self = &_peer_;
+    MPI_Comm_rank(WORLD, &self->rank);
+    MPI_Comm_size(WORLD, &self->nprocs);
+    self->secs = - MPI_Wtime();
+    self->work = NULL;
+    self->stealing = false;
+    self->retry = 0;
+    self->backoff = STEAL_BACKOFF;
+    self->counter = 0;
+    self->color = WHITE;
+    self->holding = false;
+    self->round = false;
+    self->solved = false;
+    srand(self->rank + 1);
+    if (_options_.checkpoint != NULL && self->rank == 0){
+        printf("WARNING: Checkpoints are only written with --schedule=master\n");
+        fflush(stdout);
     }
 
-    int i, row = 0, column = 0;
-    if (!find_empty(puzzle, &row, &column)){
-        return true;
-    }
+    // rank 0 reads the puzzle and every rank gets its cells
+    Board * board = broadcast_puzzle(self->rank);
+    int root_n = board->root_n;
+    self->inbox = board_create(root_n);
 
-    for (i = 1; i <= puzzle->n; ++i){
-    // Check if number can be placed in a cell
-        if (is_valid(puzzle, row, column, i)){
-            puzzle->matrix[row * puzzle->n + column] = i;
-            puzzle->depth++;
+    // the puzzle and its buffers are reused by every work item
+    Puzzle * puzzle = malloc(sizeof(Puzzle));
+    puzzle->n = board->n;
+    puzzle->root_n = root_n;
+    puzzle->depth = 1;
+    puzzle->board = board;
+    puzzle->constraints = NULL;
+    puzzle->trail = NULL;
+
+    // every rank expands the same frontier and keeps the subproblems whose index falls on it
+    _nodes_ = pool_create(sizeof(struct Node), release_node);
+    Frontier * frontier = frontier_expand(board, &_options_, self->nprocs);
+    if (frontier->solved && self->rank == 0){
+        memcpy(puzzle->board->cells, frontier->solution, puzzle->n * puzzle->n);
+        peer_solved(puzzle);
+    }
+    int item;
+    for (item = self->rank; item < frontier->count; item += self->nprocs){
+        self->work = push_cells(self->work, _nodes_, frontier_cells(frontier, item), root_n, frontier->depths[item]);
+        _stats_.spawned++;
+    }
+    frontier_free(frontier);
+
+    while (!stop_ordered()){
+        if (!is_empty(self->work)){
+            struct Node * node;
+            self->work = pop(self->work, &node);
+            memcpy(puzzle->board->cells, node->board->cells, puzzle->n * puzzle->n);
+            puzzle->depth = node->depth;
+            pool_put(_nodes_, node);
+
+            _stats_.executed++;
+            bool solved = load_constraints(puzzle);
+            if (solved){
+                solved = solve_item(puzzle);
+            }
+            if (solved){
+                peer_solved(puzzle);
+            }
+            continue;
+        }
 
-            if (solve(puzzle)){
-                return true;
+        // passive from here on, until a stolen work item arrives
+        if (self->holding){
+            pass_token();
+            continue;
+        }
+        if (self->rank == 0 && !self->round){
+            if (self->nprocs == 1){
+                peer_terminate(NULL);
+                continue;
             }
+            self->round = true;
+            self->color = WHITE;
+            self->token[0] = 0;
+            self->token[1] = WHITE;
+            MPI_Send(self->token, 2, MPI_INT, 1, TOKEN, WORLD);
+        }
+        if (!self->stealing && self->nprocs > 1 && MPI_Wtime() >= self->retry){
+            int victim = rand() % (self->nprocs - 1);
+            victim += victim >= self->rank;
+            MPI_Send(0, 0, MPI_INT, victim, STEAL_REQUEST, WORLD);
+            self->stealing = true;
+        }
 
-            puzzle->matrix[row * puzzle->n + column] = 0;
+        int flag;
+        MPI_Status status;
+        _stats_.idle -= MPI_Wtime();
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, WORLD, &flag, &status);
+        if (!flag){
+            // leaves the processor to the ranks with work when they share it
+            usleep(PEER_NAP);
+        }
+        _stats_.idle += MPI_Wtime();
+        if (flag){
+            serve(NULL, puzzle, &status);
         }
     }
-    return false;
+
+    drain();
+    if (_options_.stats == STATS_JSON) {
+        report_stats(self->solved, self->secs);
+    }
+
+    pool_free(_nodes_);
+    board_free(self->inbox);
+    cleanPuzzle(puzzle);
+    free_buffers();
+    board_free(_given_);
+    free(_wire_);
 }
 
 /**
- * Print the puzzle matrix.
+ * Handles a message of another rank of the peer to peer search.
  *
- * @param puzzle Sudoku puzzle data structure.
+ * @param search Search the rank is running, or NULL if it is passive.
+ * @param puzzle Sudoku puzzle data structure of the rank.
+ * @param status Status of the probed message.
  */
-void print_puzzle(Puzzle * puzzle){
-    if (puzzle != NULL) {
-        int n = puzzle->n;
-        int i, j;
-        for (i = 0; i < n; ++i){
-            for (j = 0; j < n; ++j){
-                printf("%d ", puzzle->matrix[i*n + j]);
-                fflush(stdout);
-            }
-            printf("\n");
-            fflush(stdout);
+void serve(Search * search, Puzzle * puzzle, MPI_Status * status) {
+    struct Peer * self = &_peer_;
+    int source = status->MPI_SOURCE;
+    int depth;
+
+    if (status->MPI_TAG == STEAL_REQUEST){
+        MPI_Recv(0, 0, MPI_INT, source, STEAL_REQUEST, WORLD, MPI_STATUS_IGNORE);
+        if (!is_empty(self->work)){
+            // a work item not started yet is given away whole
+            struct Node * node;
+            self->work = pop(self->work, &node);
+            send_cells(node->board->cells, node->depth, source, WORK_REPLY);
+            pool_put(_nodes_, node);
+            self->counter++;
+        } else if (search != NULL){
+            self->counter += donate(search, puzzle, source, WORK_REPLY);
+        } else {
+            MPI_Send(0, 0, MPI_BYTE, source, WORK_REPLY, WORLD);
+        }
+
+    } else if (status->MPI_TAG == WORK_REPLY){
+        self->stealing = false;
+        if (receive_cells(status, self->inbox->cells, &depth)){
+            self->work = push(self->work, self->inbox, depth);
+            self->counter--;
+            self->color = BLACK;
+            self->backoff = STEAL_BACKOFF;
+            _stats_.stolen++;
+        } else {
+            // the victim had nothing, waits a little longer every time before the next try
+            self->retry = MPI_Wtime() + self->backoff;
+            self->backoff = self->backoff * 2 < STEAL_BACKOFF_MAX ? self->backoff * 2 : STEAL_BACKOFF_MAX;
         }
+
+    } else if (status->MPI_TAG == TOKEN){
+        MPI_Recv(self->token, 2, MPI_INT, source, TOKEN, WORLD, MPI_STATUS_IGNORE);
+        self->holding = true;
+
+    } else if (status->MPI_TAG == SOLUTION_FOUND){
+        receive_cells(status, self->inbox->cells, NULL);
+        peer_terminate(self->inbox);
+
+    } else if (status->MPI_TAG == TERMINATE){
+        MPI_Recv(0, 0, MPI_INT, source, TERMINATE, WORLD, MPI_STATUS_IGNORE);
+        order_stop();
     }
 }
 
 /**
- * Check if number is already in a sub grid of the puzzle matrix.
+ * Handles every message already received, called between two slices of
+ * the search.
  *
- * @param puzzle Sudoku puzzle data structure.
- * @param row Row of the puzzle to check the value.
- * @param column Column of the puzzle to check the value.
- * @param number Value to compare to the one in the position given by the row and column.
- * @return Returns true if the number is inside one of the sub-grids of the matrix.
+ * @param search Search the rank is running.
+ * @param puzzle Sudoku puzzle data structure of the rank.
  */
-bool check_grid(Puzzle * puzzle, int row, int column, int number){
-    int i, j;
-    for (i = 0; i < puzzle->root_n; ++i){
-        for (j = 0; j < puzzle->root_n; ++j){
-            if (puzzle->matrix[(i + row) * puzzle->n + (j + column)] == number){
-                return true;
-            }
-        }
+void serve_pending(Search * search, Puzzle * puzzle) {
+    int flag;
+    MPI_Status status;
+    MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, WORLD, &flag, &status);
+    while (flag && !stop_ordered()){
+        serve(search, puzzle, &status);
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, WORLD, &flag, &status);
     }
-    return false;
 }
 
 /**
- * Check if a number is already in a column.
- *
- * @param puzzle Sudoku puzzle data structure.
- * @param column Column of the puzzle to check the value.
- * @param number Value to compare to the one in the position given by the column.
- * @return Returns true if the number is in the column.
+ * Passes the token on once the rank is passive. Rank 0 ends the round
+ * instead: the search is over if the token and rank 0 stayed white and the
+ * work sent and received adds up to nothing, otherwise a new round starts.
  */
-bool check_column(Puzzle * puzzle, int column, int number){
-    int i;
-    for (i = 0; i < puzzle->n; ++i){
-        if(puzzle->matrix[i* puzzle->n + column] == number){
-                return true;
+void pass_token() {
+    struct Peer * self = &_peer_;
+    self->holding = false;
+
+    if (self->rank == 0){
+        self->round = false;
+        if (self->token[1] == WHITE && self->color == WHITE && self->token[0] + self->counter == 0){
+            peer_terminate(NULL);
         }
+        return;
     }
-    return false;
+
+    self->token[0] += self->counter;
+    if (self->color == BLACK){
+        self->token[1] = BLACK;
+    }
+    self->color = WHITE;
+    MPI_Send(self->token, 2, MPI_INT, (self->rank + 1) % self->nprocs, TOKEN, WORLD);
 }
 
 /**
- * Check if a number is already in a row.
+ * Reports a solution found by the rank. Rank 0 prints it and stops every
+ * rank, the others send it to rank 0 and stop.
  *
- * @param puzzle Sudoku puzzle data structure.
- * @param row Row of the puzzle to check the value.
- * @param number Value to compare to the one in the position given by the row.
- * @return Returns true if the number is in the row.
+ * @param puzzle Sudoku puzzle data structure holding the solution.
  */
-bool check_row(Puzzle * puzzle, int row, int number){
-    int i;
-    for (i = 0; i < puzzle->n; ++i){
-        if (puzzle->matrix[row * puzzle->n + i] == number){
-            return true;
-        }
+void peer_solved(Puzzle * puzzle) {
+    if (_peer_.rank == 0){
+        peer_terminate(puzzle->board);
+    } else {
+        send_cells(puzzle->board->cells, puzzle->depth, 0, SOLUTION_FOUND);
+        order_stop();
     }
-    return false;
 }
 
 /**
- * Check if a number is already in a matrix cell according to sudoku rules.
+ * Prints the result on rank 0 and stops every other rank, only once.
  *
- * @param puzzle Sudoku puzzle data structure.
- * @param row Row of the puzzle to check the value.
- * @param column Column of the puzzle to check the value.
- * @param number Comparison value.
- * @return Returns true if the number is not valid.
+ * @param solution Board of the solution, or NULL if there is none.
  */
-bool is_valid(Puzzle * puzzle, int row, int column, int number){
-    return !(check_row(puzzle, row, number)) &&
-           !(check_column(puzzle, column, number)) &&
-           !(check_grid(puzzle, row - row % puzzle->root_n, column - column % puzzle->root_n, number));
+void peer_terminate(Board * solution) {
+    struct Peer * self = &_peer_;
+    if (stop_ordered()){
+        return;
+    }
+    order_stop();
+    self->secs += MPI_Wtime();
+    self->solved = solution != NULL;
+
+    if (solution != NULL){
+        on_solution_found(solution, self->secs);
+    } else {
+        if (!_options_.time_only_flag) {
+            printf("No solution\n");
+        }
+        if (_options_.time_flag) {
+            printf("Peak of %d work items in the pool.\n", _nodes_->peak);
+        }
+        if (_options_.time_flag || _options_.time_only_flag) {
+            printf("Elapsed time: %f (s)\n", self->secs);
+        }
+        fflush(stdout);
+    }
+
+    int rank;
+    for (rank = 1; rank < self->nprocs; rank++){
+        MPI_Send(0, 0, MPI_INT, rank, TERMINATE, WORLD);
+    }
 }
 
 /**
- * Find a empty cell in the sudoku puzzle.
- *
- * @param puzzle Sudoku puzzle data structure.
- * @param row Row number reference.
- * @param column Column number reference.
- * @return Returns true if the puzzle has an empty position.
+ * Receives and drops every message still in flight until every rank got
+ * here. Messages are only sent with blocking sends, so once every rank
+ * reached the barrier none of them waits on a send any more.
  */
-bool find_empty(Puzzle * puzzle, int * row, int * column){
-    for (*row = 0; *row < puzzle->n; (*row)++){
-        for (*column = 0; *column < puzzle->n; (*column)++){
-            if (puzzle->matrix[*row* puzzle->n + *column] == 0){
-                return true;
-            }
+void drain() {
+    MPI_Request barrier;
+    MPI_Status status;
+    int done = 0, flag, size;
+
+    MPI_Ibarrier(WORLD, &barrier);
+    while (!done){
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, WORLD, &flag, &status);
+        if (flag){
+            MPI_Get_count(&status, MPI_BYTE, &size);
+            MPI_Recv(_wire_, size, MPI_BYTE, status.MPI_SOURCE, status.MPI_TAG, WORLD, MPI_STATUS_IGNORE);
+        } else {
+            MPI_Test(&barrier, &done, MPI_STATUS_IGNORE);
         }
     }
-    return false;
 }
 
 /**
- * Creates a new puzzle based on a puzzle received as argument.
+ * Gathers the counters of every rank on the master, which prints them.
+ * Called by every rank once it stopped. The counters are sent as bytes, the
+ * ranks are expected to run on the same architecture.
  *
- * @param Puzzle Sudoku puzzle data structure to copy.
- * @return Returns a puzzle data data structure if the puzzle received
- * is not NULL if it is NULL then returns NULL.
+ * @param solved True if a solution was found, only read on the master.
+ * @param secs Elapsed time of the search, only read on the master.
  */
-Puzzle * copy_puzzle(Puzzle * puzzle) {
-    if (puzzle == NULL) {
-        return NULL;
-    }
-
-    Puzzle * copy = malloc(sizeof(Puzzle));
-    copy->root_n = puzzle->root_n;
-    copy->n = puzzle->n;
-    copy->depth = puzzle->depth;
-    copy->matrix = (int*) malloc(puzzle->n * puzzle->n * sizeof(int));
+void report_stats(bool solved, double secs){
+    int rank, nprocs;
+    MPI_Comm_rank(WORLD, &rank);
+    MPI_Comm_size(WORLD, &nprocs);
 
-    int i,j;
-    for (i = 0; i < puzzle->n; ++i){
-        for (j = 0; j < puzzle->n; ++j){
-            copy->matrix[i * puzzle->n + j] = puzzle->matrix[i * puzzle->n + j];
-        }
+    Stats * ranks = NULL;
+    if (rank == 0){
+        ranks = aligned_alloc(STATS_ALIGNMENT, nprocs * sizeof(Stats));
     }
-    return copy;
-}
-
-int * copy_matrix(int n , int * matrix){
-    int * copy = malloc( n * n * sizeof(int));
-    int i,j;
-    for(i = 0; i < n; i++){
-        for(j = 0; j < n; j++){
-            int index = i * n + j;
-            copy[index] = matrix[index];
-        }
+    MPI_Gather(&_stats_, sizeof(Stats), MPI_BYTE, ranks, sizeof(Stats), MPI_BYTE, 0, WORLD);
+    if (rank == 0){
+#ifdef _OPENMP
+        stats_print_json(stdout, "hybrid", ranks, nprocs, solved, secs);
+#else
+        stats_print_json(stdout, "mpi", ranks, nprocs, solved, secs);
+#endif
+        fflush(stdout);
+        free(ranks);
     }
-    return copy;
 }
 
+
 /**
- * Free's a Sudoku puzzle structure.
+ * Builds the constraint state of the puzzle from the values already placed
+ * and, unless disabled, fills the cells forced by propagation.
+ * Boards too wide for a mask are left without one and use the scan checks.
+ * The constraint state and trail of a puzzle that already has them are reused.
  *
  * @param puzzle Sudoku puzzle data structure.
+ * @return Returns false if two of the given values conflict or propagation finds no solution.
  */
-void cleanPuzzle (Puzzle * puzzle) {
-    if (puzzle != NULL) {
-        int n = puzzle->n;
-
-        free(puzzle->matrix);
-        free(puzzle);
+bool load_constraints(Puzzle * puzzle){
+    if (!constraints_supported(puzzle->n)){
+        free(puzzle->constraints);
+        trail_free(puzzle->trail);
+        puzzle->constraints = NULL;
+        puzzle->trail = NULL;
+        return true;
     }
-}
 
-void on_solution_found(int size, int * matrix, double secs) {
-    debug_matrix(size, matrix);
-    //printf("Elapsed time: %12.6f (s)\n", secs);
-    fflush(stdout);
+    if (puzzle->constraints == NULL){
+        puzzle->constraints = malloc(sizeof(Constraints));
+        puzzle->trail = trail_create();
+    }
+    Constraints * constraints = puzzle->constraints;
+    constraints_init(constraints, puzzle->root_n);
+    puzzle->trail->count = 0;
+
+    int row, column;
+    for (row = 0; row < puzzle->n; ++row){
+        for (column = 0; column < puzzle->n; ++column){
+            int number = board_get(puzzle->board, row, column);
+            if (number == 0){
+                continue;
+            }
+            if (!(constraints_candidates(constraints, row, column) & mask_of(number))){
+                return false;
+            }
+            constraints_place(constraints, row, column, number);
+        }
+    }
+
+    if (_options_.propagation && !constraints_propagate(constraints, puzzle->trail)){
+        return false;
+    }
+    store_values(puzzle);
+    return true;
 }
 
-void debug_matrix(int size, int * matrix){
-    if (matrix != NULL) {
-        int n = size;
-        int i, j;
-        for (i = 0; i < n; ++i){
-            for (j = 0; j < n; ++j){
-                printf("%d ", matrix[i*n + j]);
-                fflush(stdout);
+/**
+ * Copies the numbers placed on the constraint state into the board.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ */
+void store_values(Puzzle * puzzle){
+    memcpy(puzzle->board->cells, puzzle->constraints->values, puzzle->n * puzzle->n);
+}
+
+/**
+ * Attemp to solve the sudoku puzzle using backtracking.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns true if the sudoku has a solution.
+ */
+bool solve(Puzzle * puzzle){
+    // a work item taken after the stop order is not searched at all
+    if (stopping()){
+        return false;
+    }
+
+    // Boards too wide for a mask check every number with the scans
+    if (puzzle->constraints == NULL){
+        return solve_scan(puzzle);
+    }
+
+    // too small to be worth splitting, the whole subtree runs on the kernel
+    if (_options_.kernel && kernel_supported(puzzle->root_n) &&
+        puzzle->constraints->open_count <= split_cutoff(puzzle)){
+        bool solved = kernel_solve(puzzle->root_n, puzzle->constraints->values, &_options_, &_stats_, stop_requested, puzzle);
+        if (solved){
+            store_values(puzzle);
+        }
+        return solved;
+    }
+
+    if (_search_ == NULL){
+        _search_ = search_create(puzzle->constraints, puzzle->trail, &_options_);
+    } else {
+        search_init(_search_, puzzle->constraints, puzzle->trail, &_options_);
+    }
+    int result;
+    while ((result = search_run(_search_, SPLIT_INTERVAL)) == SEARCH_SUSPENDED && !stopping()){
+        if (talks_mpi()){
+            poll_messages(_search_, puzzle);
+        }
+#ifdef _OPENMP
+        share_work(_search_, puzzle);
+#endif
+    }
+    bool solved = result == SEARCH_SOLVED;
+    _stats_.nodes += _search_->states;
+    _stats_.backtracks += _search_->backtracks;
+    _stats_.propagations += _search_->propagations;
+
+    if (solved){
+        store_values(puzzle);
+    }
+    return solved;
+}
+
+/**
+ * Handles the messages that reach a rank while it searches a work item, so
+ * a stop order is seen within a few dozen branches whatever the size of the
+ * work item. The master sends a slave a split request, its next batch,
+ * a checkpoint or the stop order while it works; the batch and the stop
+ * order are left for slave() to receive, a split request is answered with
+ * a work item of the batch not started yet, or else with a branch of the
+ * search, a checkpoint with the work of the slave. In the peer to peer
+ * mode every pending message is served.
+ *
+ * @param search Suspended search of the rank, or NULL if the engine can not be split.
+ * @param puzzle Sudoku puzzle data structure being searched.
+ */
+void poll_messages(Search * search, Puzzle * puzzle){
+    if (_options_.schedule == SCHEDULE_STEAL){
+        serve_pending(search, puzzle);
+        return;
+    }
+
+    int flag;
+    MPI_Iprobe(0, STOP_WORK, WORLD, &flag, MPI_STATUS_IGNORE);
+    if (flag){
+        order_stop();
+        return;
+    }
+    if (_options_.checkpoint != NULL){
+        MPI_Iprobe(0, CHECKPOINT, WORLD, &flag, MPI_STATUS_IGNORE);
+        if (flag){
+            save_work(search);
+        }
+    }
+    // a split request met outside the search is answered once the work item is over
+    if (search != NULL || _batch_.count > 0){
+        MPI_Iprobe(0, SPLIT_WORK, WORLD, &flag, MPI_STATUS_IGNORE);
+        if (flag){
+            MPI_Recv(0, 0, MPI_INT, 0, SPLIT_WORK, WORLD, MPI_STATUS_IGNORE);
+            if (_batch_.count > 0){
+                // a work item of the batch not started yet goes back whole
+                struct Node * node;
+                _batch_.items = pop(_batch_.items, &node);
+                _batch_.count--;
+                send_cells(node->board->cells, node->depth, 0, DONATE_WORK);
+                pool_put(_nodes_, node);
+                _batch_.done++;
+            } else {
+                donate(search, puzzle, 0, DONATE_WORK);
             }
-            printf("\n");
+        }
+    }
+}
+
+/**
+ * Stop hook of the kernel and of Dancing Links, also called on every state
+ * of the scans. Checks for messages every STOP_POLL_CALLS calls, few enough
+ * that probing costs little next to the search. In the hybrid build only
+ * the thread that talks MPI polls, so it is the only one that counts its
+ * calls and the counter needs no synchronisation; the other threads only
+ * read the stop order.
+ *
+ * @param data Sudoku puzzle data structure being searched.
+ * @return Returns non-zero once the rank was told to stop.
+ */
+int stop_requested(void * data){
+    // only changed by the thread that talks MPI
+    static int calls = 0;
+    if (talks_mpi() && ++calls == STOP_POLL_CALLS){
+        calls = 0;
+        poll_messages(NULL, data);
+    }
+    return stopping();
+}
+
+/**
+ * Whether the search of the calling thread should give up: the rank was
+ * told to stop, or another thread of the rank found a solution.
+ *
+ * @return Returns true once the search should stop.
+ */
+bool stopping(){
+#ifdef _OPENMP
+    int found;
+    #pragma omp atomic read
+    found = _team_.found;
+    return stop_ordered() || found;
+#else
+    return stop_ordered();
+#endif
+}
+
+/**
+ * Whether the rank was told to stop. The flag is set by the thread that
+ * talks MPI and read by every thread of the hybrid build, so it is only
+ * read and written atomically.
+ *
+ * @return Returns true once the rank was told to stop.
+ */
+bool stop_ordered(){
+    bool stop;
+#ifdef _OPENMP
+    #pragma omp atomic read
+#endif
+    stop = ORDER_STOP_WORKING;
+    return stop;
+}
+
+/**
+ * Tells every thread of the rank to stop.
+ */
+void order_stop(){
+#ifdef _OPENMP
+    #pragma omp atomic write
+#endif
+    ORDER_STOP_WORKING = true;
+}
+
+/**
+ * Whether the calling thread is the one of the rank that sends and
+ * receives messages, the main thread of the hybrid build.
+ *
+ * @return Returns true if the thread may call MPI.
+ */
+bool talks_mpi(){
+#ifdef _OPENMP
+    return omp_get_thread_num() == 0;
+#else
+    return true;
+#endif
+}
+
+/**
+ * Searches a work item whose constraints are loaded, with every thread of
+ * the rank in the hybrid build.
+ *
+ * @param puzzle Sudoku puzzle data structure of the work item.
+ * @return Returns true if the work item holds a solution, left in the board.
+ */
+bool solve_item(Puzzle * puzzle){
+#ifdef _OPENMP
+    if (omp_get_max_threads() > 1){
+        return solve_team(puzzle);
+    }
+#endif
+    return _options_.engine == ENGINE_DLX ? solve_dlx(puzzle) : solve(puzzle);
+}
+
+/**
+ * Frees the search buffers of the rank, those of every thread in the
+ * hybrid build.
+ */
+void free_buffers(){
+#ifdef _OPENMP
+    #pragma omp parallel
+    {
+        cleanPuzzle(_mine_);
+        _mine_ = NULL;
+        search_free(_search_);
+        _search_ = NULL;
+        free(_donation_);
+        _donation_ = NULL;
+        puzzles_scratch_free(_scratch_);
+        _scratch_ = NULL;
+    }
+    pool_free(_team_.nodes);
+    _team_.nodes = NULL;
+#else
+    search_free(_search_);
+    free(_donation_);
+    puzzles_scratch_free(_scratch_);
+#endif
+}
+
+#ifdef _OPENMP
+/**
+ * Searches a work item with the threads of the rank. The frontier of the
+ * work item goes on the stack of the team and every thread takes branches
+ * off it until the stack is empty with no thread searching, or a solution
+ * was found. The main thread keeps answering the messages of the other
+ * ranks between its slices and while it waits for a branch.
+ *
+ * @param puzzle Sudoku puzzle data structure of the work item, constraints loaded.
+ * @return Returns true if the work item holds a solution, copied into its board.
+ */
+bool solve_team(Puzzle * puzzle){
+    int r, c;
+    if (!select_cell(puzzle, &r, &c)){
+        // propagation alone filled the work item
+        return true;
+    }
+    Frontier * frontier = frontier_expand(puzzle->board, &_options_, omp_get_max_threads());
+    if (frontier->solved){
+        memcpy(puzzle->board->cells, frontier->solution, puzzle->n * puzzle->n);
+        frontier_free(frontier);
+        return true;
+    }
+    if (_team_.nodes == NULL){
+        _team_.nodes = pool_create(sizeof(struct Node), release_node);
+    }
+    _team_.work = NULL;
+    _team_.queued = 0;
+    _team_.busy = 0;
+    _team_.found = false;
+    stats_clear(&_team_.stats);
+    // pushed last to first, the threads take the subproblems in the order of the expansion
+    int item;
+    for (item = frontier->count - 1; item >= 0; item--){
+        _team_.work = push_cells(_team_.work, _team_.nodes, frontier_cells(frontier, item), puzzle->root_n, puzzle->depth + frontier->depths[item]);
+        _team_.queued++;
+        _stats_.spawned++;
+    }
+    frontier_free(frontier);
+
+    #pragma omp parallel
+    {
+        if (_mine_ == NULL || _mine_->root_n != puzzle->root_n){
+            cleanPuzzle(_mine_);
+            _mine_ = malloc(sizeof(Puzzle));
+            _mine_->board = board_create(puzzle->root_n);
+            _mine_->n = puzzle->n;
+            _mine_->root_n = puzzle->root_n;
+            _mine_->constraints = NULL;
+            _mine_->trail = NULL;
+        }
+
+        while (!stopping()){
+            struct Node * node = NULL;
+            bool over = false;
+            #pragma omp critical(team)
+            {
+                if (!is_empty(_team_.work)){
+                    _team_.work = pop(_team_.work, &node);
+                    memcpy(_mine_->board->cells, node->board->cells, puzzle->n * puzzle->n);
+                    _mine_->depth = node->depth;
+                    pool_put(_team_.nodes, node);
+                    _team_.queued--;
+                    _team_.busy++;
+                } else {
+                    over = _team_.busy == 0;
+                }
+            }
+            if (over){
+                break;
+            }
+            if (node == NULL){
+                // wait for a thread to share a branch
+                _stats_.idle -= omp_get_wtime();
+                if (talks_mpi()){
+                    poll_messages(NULL, _mine_);
+                }
+                usleep(PEER_NAP);
+                _stats_.idle += omp_get_wtime();
+                continue;
+            }
+
+            bool solved = load_constraints(_mine_);
+            if (solved){
+                solved = _options_.engine == ENGINE_DLX ? solve_dlx(_mine_) : solve(_mine_);
+            }
+            #pragma omp critical(team)
+            {
+                if (solved && !_team_.found){
+                    memcpy(puzzle->board->cells, _mine_->board->cells, puzzle->n * puzzle->n);
+                    #pragma omp atomic write
+                    _team_.found = true;
+                }
+                _team_.busy--;
+            }
+        }
+
+        if (!talks_mpi()){
+            #pragma omp critical(team)
+            stats_add(&_team_.stats, &_stats_);
+            stats_clear(&_stats_);
+        }
+    }
+
+    // branches left after a solution or a stop order go back to the pool
+    while (!is_empty(_team_.work)){
+        struct Node * node;
+        _team_.work = pop(_team_.work, &node);
+        pool_put(_team_.nodes, node);
+    }
+    stats_add(&_stats_, &_team_.stats);
+    return _team_.found;
+}
+
+/**
+ * Splits the shallowest untried branch off the search of a thread onto the
+ * stack of the team, when the stack is empty while threads wait for work.
+ *
+ * @param search Suspended search of the thread.
+ * @param puzzle Sudoku puzzle data structure being searched.
+ */
+void share_work(Search * search, Puzzle * puzzle){
+    int queued, busy;
+    if (!omp_in_parallel()){
+        return;
+    }
+    #pragma omp atomic read
+    queued = _team_.queued;
+    #pragma omp atomic read
+    busy = _team_.busy;
+    if (queued > 0 || busy == omp_get_num_threads()){
+        return;
+    }
+
+    if (_donation_ == NULL){
+        _donation_ = malloc(sizeof(Constraints));
+    }
+    int cell, number;
+    int depth = search_split(search, split_cutoff(puzzle), _donation_, &cell, &number);
+    if (depth < 0){
+        return;
+    }
+    _donation_->values[cell] = number;
+    #pragma omp critical(team)
+    {
+        _team_.work = push_cells(_team_.work, _team_.nodes, _donation_->values, puzzle->root_n, puzzle->depth + depth + 1);
+        _team_.queued++;
+    }
+    _stats_.spawned++;
+}
+#endif
+
+/**
+ * Answers a split request, of the master or of a thief, with the shallowest
+ * untried branch of the search, the largest one, as the cells of a new work
+ * item; or with an empty message if no branch leaves more empty cells than
+ * the cutoff.
+ *
+ * @param search Suspended search of the rank.
+ * @param puzzle Sudoku puzzle data structure being searched.
+ * @param rank Rank that asked for the split.
+ * @param tag Tag of the answer.
+ * @return Returns true if a branch was sent.
+ */
+bool donate(Search * search, Puzzle * puzzle, int rank, int tag){
+    if (_donation_ == NULL){
+        _donation_ = malloc(sizeof(Constraints));
+    }
+
+    int cell, number;
+    int depth = search_split(search, split_cutoff(puzzle), _donation_, &cell, &number);
+    if (depth < 0){
+        MPI_Send(0, 0, MPI_BYTE, rank, tag, WORLD);
+        return false;
+    }
+    // the branch is propagated by the rank that gets it
+    _donation_->values[cell] = number;
+    send_cells(_donation_->values, puzzle->depth + depth + 1, rank, tag);
+    _stats_.spawned++;
+    return true;
+}
+
+/**
+ * Reads the puzzle on rank 0 and gives it to every rank, which keeps a copy
+ * to decode the work items and solutions it receives.
+ *
+ * @param rank Rank of the calling process.
+ * @return Returns a board holding the puzzle, for the rank to work on.
+ */
+Board * broadcast_puzzle(int rank){
+    int root_n = 0;
+    Board * board = NULL;
+    if (rank == 0){
+        FILE * file_input = fopen(_options_.filename, "r");
+        if (file_input == NULL){
+            printf("ERROR: Could not open file %s\n", _options_.filename);
             fflush(stdout);
+            MPI_Abort(WORLD, EXIT_FAILURE);
+        }
+        board = board_read(file_input);
+        fclose(file_input);
+        if (board == NULL){
+            printf("ERROR: Could not read puzzle from file %s\n", _options_.filename);
+            fflush(stdout);
+            MPI_Abort(WORLD, EXIT_FAILURE);
+        }
+        root_n = board->root_n;
+    }
+    MPI_Bcast(&root_n, 1, MPI_INT, 0, WORLD);
+    if (rank != 0){
+        board = board_create(root_n);
+    }
+    MPI_Bcast(board->cells, board->n * board->n, MPI_UNSIGNED_CHAR, 0, WORLD);
+
+    _given_ = board_copy(board);
+    _wire_ = malloc(BATCH_MAX * wire_capacity(root_n));
+    return board;
+}
+
+/**
+ * Sends the cells of a work item or a solution, as the cells filled since
+ * the given puzzle when they are few.
+ *
+ * @param cells Cells to send.
+ * @param depth Decisions taken from the given puzzle.
+ * @param rank Rank to send to.
+ * @param tag Tag of the message.
+ */
+void send_cells(uint8_t * cells, int depth, int rank, int tag){
+    size_t size = wire_encode(_wire_, _given_, cells, depth);
+    MPI_Send(_wire_, size, MPI_BYTE, rank, tag, WORLD);
+}
+
+/**
+ * Receives the message of a work item or a solution, or an empty answer.
+ *
+ * @param status Status of the probed message.
+ * @param cells Cells to fill, as many as the given puzzle.
+ * @param depth Set to the decisions taken from the given puzzle, or NULL.
+ * @return Returns true if the message held cells, false if it was empty.
+ */
+bool receive_cells(MPI_Status * status, uint8_t * cells, int * depth){
+    int size;
+    MPI_Get_count(status, MPI_BYTE, &size);
+    MPI_Recv(_wire_, size, MPI_BYTE, status->MPI_SOURCE, status->MPI_TAG, WORLD, MPI_STATUS_IGNORE);
+    if (size == 0){
+        return false;
+    }
+    if (!wire_decode(_wire_, size, _given_, cells, depth)){
+        printf("ERROR: Malformed message from rank %d\n", status->MPI_SOURCE);
+        fflush(stdout);
+        MPI_Abort(WORLD, EXIT_FAILURE);
+    }
+    return true;
+}
+
+/**
+ * Empty cells at or below which a work item is solved by the kernel and no
+ * branch is split off for another slave.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns the cutoff of the options, the board width by default.
+ */
+int split_cutoff(Puzzle * puzzle){
+    return _options_.cutoff >= 0 ? _options_.cutoff : puzzle->n;
+}
+
+/**
+ * Attemp to solve the sudoku puzzle using recursive backtracking over the
+ * matrix, checking every number with the row, column and grid scans.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns true if the sudoku has a solution.
+ */
+bool solve_scan(Puzzle * puzzle){
+    if (stop_requested(puzzle)){
+        return false;
+    }
+    _stats_.nodes++;
+    int i, row = 0, column = 0;
+    if (!find_empty(puzzle, &row, &column)){
+        return true;
+    }
+
+    for (i = 1; i <= puzzle->n; ++i){
+    // Check if number can be placed in a cell
+        if (is_valid(puzzle, row, column, i)){
+            board_set(puzzle->board, row, column, i);
+            puzzle->depth++;
+
+            if (solve_scan(puzzle)){
+                return true;
+            }
+
+            board_set(puzzle->board, row, column, 0);
+        }
+    }
+    _stats_.backtracks++;
+    return false;
+}
+
+/**
+ * Attemp to solve the sudoku puzzle with the dancing links exact cover search.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns true if the sudoku has a solution.
+ */
+bool solve_dlx(Puzzle * puzzle){
+    Dlx * dlx = dlx_create(puzzle->root_n, puzzle->board->cells);
+    if (dlx == NULL){
+        return false;
+    }
+    dlx->stop = stop_requested;
+    dlx->data = puzzle;
+    bool solved = dlx_solve(dlx, puzzle->board->cells);
+    _stats_.nodes += dlx->states;
+    _stats_.backtracks += dlx->backtracks;
+    dlx_free(dlx);
+    return solved;
+}
+
+/**
+ * Print the puzzle matrix.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ */
+void print_puzzle(Puzzle * puzzle){
+    if (puzzle != NULL) {
+        board_print(stdout, puzzle->board);
+        fflush(stdout);
+    }
+}
+
+/**
+ * Check if number is already in a sub grid of the puzzle matrix.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @param row Row of the puzzle to check the value.
+ * @param column Column of the puzzle to check the value.
+ * @param number Value to compare to the one in the position given by the row and column.
+ * @return Returns true if the number is inside one of the sub-grids of the matrix.
+ */
+bool check_grid(Puzzle * puzzle, int row, int column, int number){
+    int i, j;
+    for (i = 0; i < puzzle->root_n; ++i){
+        for (j = 0; j < puzzle->root_n; ++j){
+            if (board_get(puzzle->board, i + row, j + column) == number){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Check if a number is already in a column.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @param column Column of the puzzle to check the value.
+ * @param number Value to compare to the one in the position given by the column.
+ * @return Returns true if the number is in the column.
+ */
+bool check_column(Puzzle * puzzle, int column, int number){
+    int i;
+    for (i = 0; i < puzzle->n; ++i){
+        if(board_get(puzzle->board, i, column) == number){
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Check if a number is already in a row.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @param row Row of the puzzle to check the value.
+ * @param number Value to compare to the one in the position given by the row.
+ * @return Returns true if the number is in the row.
+ */
+bool check_row(Puzzle * puzzle, int row, int number){
+    int i;
+    for (i = 0; i < puzzle->n; ++i){
+        if (board_get(puzzle->board, row, i) == number){
+            return true;
         }
     }
+    return false;
+}
+
+/**
+ * Check if a number is already in a matrix cell according to sudoku rules.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @param row Row of the puzzle to check the value.
+ * @param column Column of the puzzle to check the value.
+ * @param number Comparison value.
+ * @return Returns true if the number is not valid.
+ */
+bool is_valid(Puzzle * puzzle, int row, int column, int number){
+    if (puzzle->constraints != NULL){
+        return (constraints_candidates(puzzle->constraints, row, column) & mask_of(number)) != 0;
+    }
+    return !(check_row(puzzle, row, number)) &&
+           !(check_column(puzzle, column, number)) &&
+           !(check_grid(puzzle, row - row % puzzle->root_n, column - column % puzzle->root_n, number));
 }
 
+/**
+ * Find a empty cell in the sudoku puzzle.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @param row Row number reference.
+ * @param column Column number reference.
+ * @return Returns true if the puzzle has an empty position.
+ */
+bool find_empty(Puzzle * puzzle, int * row, int * column){
+    for (*row = 0; *row < puzzle->n; (*row)++){
+        for (*column = 0; *column < puzzle->n; (*column)++){
+            if (board_get(puzzle->board, *row, *column) == 0){
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
+/**
+ * Selects the cell to branch on, either the first empty cell or, when the
+ * puzzle has a constraint state and the mrv branching was requested, the
+ * empty cell with the fewest candidates.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @param row Row number reference.
+ * @param column Column number reference.
+ * @return Returns true if the puzzle has an empty position.
+ */
+bool select_cell(Puzzle * puzzle, int * row, int * column){
+    if (puzzle->constraints == NULL || _options_.branching == BRANCH_FIRST){
+        return find_empty(puzzle, row, column);
+    }
 
-void init(struct Node * head){
-    head = NULL;
+    int cell = constraints_select_cell(puzzle->constraints);
+    if (cell < 0){
+        return false;
+    }
+    *row = cell / puzzle->n;
+    *column = cell % puzzle->n;
+    return true;
 }
 
+/**
+ * Creates a new puzzle based on a puzzle received as argument.
+ *
+ * @param Puzzle Sudoku puzzle data structure to copy.
+ * @return Returns a puzzle data data structure if the puzzle received
+ * is not NULL if it is NULL then returns NULL.
+ */
+Puzzle * copy_puzzle(Puzzle * puzzle) {
+    if (puzzle == NULL) {
+        return NULL;
+    }
+
+    Puzzle * copy = malloc(sizeof(Puzzle));
+    copy->root_n = puzzle->root_n;
+    copy->n = puzzle->n;
+    copy->depth = puzzle->depth;
+    copy->constraints = constraints_copy(puzzle->constraints);
+    copy->trail = puzzle->trail != NULL ? trail_create() : NULL;
+    copy->board = board_copy(puzzle->board);
+    return copy;
+}
+
+/**
+ * Free's a Sudoku puzzle structure.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ */
+void cleanPuzzle (Puzzle * puzzle) {
+    if (puzzle != NULL) {
+        board_free(puzzle->board);
+        free(puzzle->constraints);
+        trail_free(puzzle->trail);
+        free(puzzle);
+    }
+}
+
+void on_solution_found(Board * board, double secs) {
+    if (!_options_.time_only_flag) {
+        board_print(stdout, board);
+    }
+    if (_options_.time_flag) {
+        printf("Peak of %d work items in the pool.\n", _nodes_->peak);
+    }
+    if (_options_.time_flag || _options_.time_only_flag) {
+        printf("Elapsed time: %f (s)\n", secs);
+    }
+    fflush(stdout);
+}
+
+
+
 bool is_empty(struct Node * top){
     return (top == NULL) ? true : false;
 }
 
-struct Node * push(struct Node * head, int n, int * matrix){
-    struct Node * tmp = (struct Node *) malloc(sizeof(struct Node));
-    tmp->n = n;
-    tmp->matrix = matrix;
+struct Node * push(struct Node * head, Board * board, int depth){
+    return push_cells(head, _nodes_, board->cells, board->root_n, depth);
+}
+
+/**
+ * Pushes a copy of some cells onto a stack of work items.
+ *
+ * @param head Top of the stack.
+ * @param nodes Pool the nodes of the stack come from.
+ * @param cells Cells of the work item.
+ * @param root_n Square root of the number of rows and columns.
+ * @param depth Decisions taken from the given puzzle.
+ * @return Returns the new top of the stack.
+ */
+struct Node * push_cells(struct Node * head, Pool * nodes, uint8_t * cells, int root_n, int depth){
+    struct Node * tmp = pool_get(nodes);
+    if (tmp->board == NULL || tmp->board->root_n != root_n){
+        board_free(tmp->board);
+        tmp->board = board_create(root_n);
+    }
+    memcpy(tmp->board->cells, cells, tmp->board->n * tmp->board->n);
+    tmp->depth = depth;
     tmp->next = head;
     head = tmp;
     return head;
 }
 
-struct Node * pop(struct Node * head, int * n, int ** matrix){
-    struct Node * tmp = head;
-    *n = head->n;
-    *matrix = head->matrix;
+struct Node * pop(struct Node * head, struct Node ** node){
+    *node = head;
     head = head->next;
-    free(tmp);
     return head;
 }
+
+/**
+ * Frees the board a node of the work pool kept, called on every node of
+ * the pool when the pool is freed.
+ *
+ * @param block Node of the pool.
+ */
+void release_node(void * block){
+    struct Node * node = block;
+    board_free(node->board);
+}
+
+/**
+ * Puts a node on the master's queue.
+ *
+ * @param queue Queue of the master.
+ * @param node Node holding a work item and the estimated size of its subtree.
+ */
+void queue_push(struct Queue * queue, struct Node * node){
+    if (queue->count == queue->capacity){
+        queue->capacity = queue->capacity > 0 ? queue->capacity * 2 : 16;
+        queue->items = realloc(queue->items, queue->capacity * sizeof(struct Node *));
+    }
+    int child = queue->count++, parent;
+    for (; child > 0; child = parent){
+        parent = (child - 1) / 2;
+        if (queue->items[parent]->estimate >= node->estimate){
+            break;
+        }
+        queue->items[child] = queue->items[parent];
+    }
+    queue->items[child] = node;
+}
+
+/**
+ * Takes the work item with the largest subtree off the master's queue.
+ *
+ * @param queue Queue of the master, not empty.
+ * @return Returns the node of the work item.
+ */
+struct Node * queue_pop(struct Queue * queue){
+    struct Node * top = queue->items[0];
+    struct Node * last = queue->items[--queue->count];
+    int parent = 0, child;
+    while ((child = 2 * parent + 1) < queue->count){
+        if (child + 1 < queue->count && queue->items[child + 1]->estimate > queue->items[child]->estimate){
+            child++;
+        }
+        if (last->estimate >= queue->items[child]->estimate){
+            break;
+        }
+        queue->items[parent] = queue->items[child];
+        parent = child;
+    }
+    queue->items[parent] = last;
+    return top;
+}
+
+/**
+ * Puts the work item in the board of the puzzle on the master's queue,
+ * ranked by the size of its subtree: the logarithm of the product of the
+ * candidate counts of its empty cells once propagated, or the number of
+ * empty cells on boards too wide for a constraint state. A work item left
+ * without a candidate for some cell is dropped.
+ *
+ * @param queue Queue of the master.
+ * @param puzzle Sudoku puzzle data structure holding the work item.
+ * @param depth Decisions taken from the given puzzle.
+ * @return Returns true if propagation alone solved the work item, left in the board.
+ */
+bool enqueue(struct Queue * queue, Puzzle * puzzle, int depth){
+    if (!load_constraints(puzzle)){
+        return false;
+    }
+
+    int open = 0, cell;
+    double estimate = 0;
+    if (puzzle->constraints != NULL){
+        Constraints * constraints = puzzle->constraints;
+        open = constraints->open_count;
+        for (cell = 0; cell < open; ++cell){
+            int row = constraints->open[cell] / puzzle->n, column = constraints->open[cell] % puzzle->n;
+            estimate += log2(mask_count(constraints_candidates(constraints, row, column)));
+        }
+    } else {
+        for (cell = 0; cell < puzzle->n * puzzle->n; ++cell){
+            open += puzzle->board->cells[cell] == 0;
+        }
+        estimate = open;
+    }
+    if (open == 0){
+        return true;
+    }
+
+    struct Node * node = pool_get(_nodes_);
+    if (node->board == NULL || node->board->root_n != puzzle->root_n){
+        board_free(node->board);
+        node->board = board_create(puzzle->root_n);
+    }
+    memcpy(node->board->cells, puzzle->board->cells, puzzle->n * puzzle->n);
+    node->depth = depth;
+    node->open = open;
+    node->estimate = estimate;
+    queue_push(queue, node);
+    return false;
+}
+
+/**
+ * Splits the largest work items of the master's queue into the branches of
+ * the cell they would branch on, while fewer work items are queued than
+ * wanted or the largest one would take longer than all the others together.
+ * Work items at or below the cutoff are never split.
+ *
+ * @param queue Queue of the master.
+ * @param puzzle Sudoku puzzle data structure the work items are loaded in.
+ * @param parent Board the cells of the split work item are kept in.
+ * @param wanted Work items wanted on the queue.
+ * @param limit Work items queued at most.
+ * @return Returns true if propagation alone solved a branch, left in the board of the puzzle.
+ */
+bool refine(struct Queue * queue, Puzzle * puzzle, Board * parent, int wanted, int limit){
+    int numbers[puzzle->n];
+    while (queue->count > 0 && queue->count < limit && queue->items[0]->open > split_cutoff(puzzle) &&
+           (queue->count < wanted || dominates(queue))){
+        struct Node * node = queue_pop(queue);
+        int depth = node->depth;
+        memcpy(parent->cells, node->board->cells, puzzle->n * puzzle->n);
+        memcpy(puzzle->board->cells, node->board->cells, puzzle->n * puzzle->n);
+        pool_put(_nodes_, node);
+
+        // the constraint state is reloaded by every branch, its candidates are kept first
+        int r, c, num, count = 0, i;
+        load_constraints(puzzle);
+        select_cell(puzzle, &r, &c);
+        for (num = 1; num <= puzzle->n; num++){
+            if (is_valid(puzzle, r, c, num)){
+                numbers[count++] = num;
+            }
+        }
+        for (i = 0; i < count; ++i){
+            memcpy(puzzle->board->cells, parent->cells, puzzle->n * puzzle->n);
+            board_set(puzzle->board, r, c, numbers[i]);
+            _stats_.spawned++;
+            if (enqueue(queue, puzzle, depth + 1)){
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**
+ * Whether the largest work item of the master's queue is estimated to take
+ * longer than all the others together.
+ *
+ * @param queue Queue of the master, not empty.
+ * @return Returns true if the largest subtree outweighs the rest of the queue.
+ */
+bool dominates(struct Queue * queue){
+    double top = queue->items[0]->estimate, rest = 0;
+    int i;
+    for (i = 1; i < queue->count; ++i){
+        // sizes relative to the largest, so the powers stay in range
+        rest += exp2(queue->items[i]->estimate - top);
+    }
+    return rest < 1;
+}
+
+/**
+ * Number of work items the master sends a slave at once: as many as the
+ * slave searches in BATCH_SECONDS at the pace of its last work items, one
+ * until it reported any, and never more than its share of the queue so
+ * the other slaves are not left without work.
+ *
+ * @param pace Seconds a work item takes the slave, 0 if unknown.
+ * @param queued Work items in the queue.
+ * @param slaves Number of slaves.
+ * @return Returns the size of the batch, from 1 to BATCH_MAX.
+ */
+int batch_size(double pace, int queued, int slaves){
+    int size = 1;
+    if (pace > 0){
+        size = BATCH_SECONDS / pace < BATCH_MAX ? (int) (BATCH_SECONDS / pace) : BATCH_MAX;
+    }
+    if (size > queued / slaves){
+        size = queued / slaves;
+    }
+    return size > 1 ? size : 1;
+}
+
+/**
+ * Sends the largest work items of the queue to a slave as one message,
+ * their wire messages back to back.
+ *
+ * @param queue Work items of the master, at least count of them.
+ * @param count Work items to send.
+ * @param rank Rank of the slave.
+ */
+void send_batch(struct Queue * queue, int count, int rank){
+    struct Node * items[BATCH_MAX];
+    size_t size = 0;
+    int i;
+    for (i = 0; i < count; i++){
+        items[i] = queue_pop(queue);
+    }
+    // the slave stacks them, written smallest first it searches the largest first
+    for (i = count - 1; i >= 0; i--){
+        size += wire_encode(_wire_ + size, _given_, items[i]->board->cells, items[i]->depth);
+        pool_put(_nodes_, items[i]);
+    }
+    MPI_Send(_wire_, size, MPI_BYTE, rank, START_WORK, WORLD);
+}
+
+/**
+ * Receives a batch of work items from the master onto the work items of
+ * the slave.
+ *
+ * @param status Status of the probed message.
+ */
+void receive_batch(MPI_Status * status){
+    int size, depth;
+    MPI_Get_count(status, MPI_BYTE, &size);
+    MPI_Recv(_wire_, size, MPI_BYTE, 0, START_WORK, WORLD, MPI_STATUS_IGNORE);
+
+    size_t offset = 0, bytes;
+    while (offset < (size_t) size){
+        bytes = wire_size(_wire_ + offset, size - offset);
+        if (bytes == 0 || !wire_decode(_wire_ + offset, bytes, _given_, _batch_.inbox->cells, &depth)){
+            printf("ERROR: Malformed message from rank %d\n", status->MPI_SOURCE);
+            fflush(stdout);
+            MPI_Abort(WORLD, EXIT_FAILURE);
+        }
+        _batch_.items = push_cells(_batch_.items, _nodes_, _batch_.inbox->cells, _batch_.inbox->root_n, depth);
+        _batch_.count++;
+        offset += bytes;
+    }
+    _batch_.received++;
+}
+
+/**
+ * Tells the master how many work items the slave finished or gave back
+ * since its last report and the seconds it spent on them, as doubles.
+ *
+ * @param tag ASK_FOR_WORK to ask for the next batch with the report, NO_SOLUTION_FOUND to only report.
+ */
+void report_done(int tag){
+    double report[2] = {_batch_.done, _batch_.spent};
+    MPI_Send(report, 2, MPI_DOUBLE, 0, tag, WORLD);
+    _batch_.done = 0;
+    _batch_.spent = 0;
+}
+
+/**
+ * Starts a checkpoint on the master: the work items of its queue are saved
+ * and every slave is asked for its work along with the number of batches
+ * it was sent, so the slave saves every work item sent before the
+ * checkpoint whether it received it yet or not. A work item a slave gives
+ * back before it answers is saved as it comes, the search goes on meanwhile.
+ *
+ * @param queue Work items of the master.
+ * @param batches Batches sent to every slave.
+ * @param saving Set for every slave, until it answered.
+ * @param nprocs Number of ranks.
+ */
+void begin_checkpoint(struct Queue * queue, int * batches, bool * saving, int nprocs){
+    checkpoint_clear(_checkpoint_);
+    int i;
+    for (i = 0; i < queue->count; i++){
+        checkpoint_add(_checkpoint_, queue->items[i]->board->cells, queue->items[i]->depth);
+    }
+    for (i = 1; i < nprocs; i++){
+        MPI_Send(&batches[i], 1, MPI_INT, i, CHECKPOINT, WORLD);
+        saving[i] = true;
+    }
+}
+
+/**
+ * Answers a checkpoint of the master with the work of the slave. The
+ * batches sent before the checkpoint are received first; then the work
+ * items not started yet and what is left of the one being searched go to
+ * the master: the untried branches of the search if it is the search of
+ * the work item, or else the whole work item, as with the kernel or the
+ * threads of the hybrid build.
+ *
+ * @param search Suspended search of the slave, or NULL.
+ */
+void save_work(Search * search){
+    int expected;
+    MPI_Status status;
+    MPI_Recv(&expected, 1, MPI_INT, 0, CHECKPOINT, WORLD, MPI_STATUS_IGNORE);
+    while (_batch_.received < expected){
+        MPI_Probe(0, START_WORK, WORLD, &status);
+        receive_batch(&status);
+        _batch_.asked = false;
+    }
+
+    if (_saved_ == NULL){
+        _saved_ = checkpoint_create(_given_);
+    }
+    checkpoint_clear(_saved_);
+    struct Node * node;
+    for (node = _batch_.items; node != NULL; node = node->next){
+        checkpoint_add(_saved_, node->board->cells, node->depth);
+    }
+    Puzzle * current = _batch_.current;
+    if (current != NULL){
+        if (search != NULL && search->constraints == current->constraints && search->status == SEARCH_SUSPENDED){
+            checkpoint_add_search(_saved_, search, current->depth);
+        } else {
+            checkpoint_add(_saved_, current->board->cells, current->depth);
+        }
+    }
+    MPI_Send(_saved_->items, _saved_->size, MPI_BYTE, 0, CHECKPOINT_ITEMS, WORLD);
+}
+
+/**
+ * Master of the batch mode. It reads every puzzle of the batch file and
+ * hands them to the slaves in chunks of consecutive puzzles, smaller as
+ * fewer are left, and keeps PUZZLES_IN_FLIGHT chunks at every slave so the
+ * next one is there as it finishes one. A slave answers a chunk with its
+ * solutions, which the master puts in place; it prints them in the order
+ * of the file once every chunk came back. Alone, it solves them itself.
+ */
+void master_batch() {
+    // Start counter
+    double secs = - MPI_Wtime();
+    int nprocs;
+    MPI_Comm_size(WORLD, &nprocs);
+
+    FILE * file_input = fopen(_options_.filename, "r");
+    if (file_input == NULL){
+        printf("ERROR: Could not open file %s\n", _options_.filename);
+        fflush(stdout);
+        MPI_Abort(WORLD, EXIT_FAILURE);
+    }
+    Puzzles * puzzles = puzzles_read(file_input);
+    fclose(file_input);
+    if (puzzles == NULL){
+        printf("ERROR: Could not read puzzles from file %s\n", _options_.filename);
+        fflush(stdout);
+        MPI_Abort(WORLD, EXIT_FAILURE);
+    }
+    MPI_Bcast(&puzzles->root_n, 1, MPI_INT, 0, WORLD);
+
+    int slaves = nprocs - 1, size = puzzles->n * puzzles->n;
+    int bytes = 2 * sizeof(int) + PUZZLES_CHUNK_MAX * (size + 1);
+    // a buffer and a request per chunk in flight at every slave, and one for the solutions
+    uint8_t * chunks = malloc((size_t) nprocs * PUZZLES_IN_FLIGHT * bytes);
+    uint8_t * inbox = malloc(bytes);
+    MPI_Request requests[nprocs][PUZZLES_IN_FLIGHT];
+    // chunks sent to every slave and not answered yet, and sent in total
+    int outstanding[nprocs];
+    int sent[nprocs];
+    int next = 0, running = 0, iter, slot;
+    if (slaves == 0){
+        solve_puzzles(puzzles);
+        next = puzzles->count;
+    }
+
+    for (iter = 1; iter < nprocs; ++iter){
+        outstanding[iter] = 0;
+        sent[iter] = 0;
+        for (slot = 0; slot < PUZZLES_IN_FLIGHT; ++slot){
+            requests[iter][slot] = MPI_REQUEST_NULL;
+        }
+    }
+    for (slot = 0; slot < PUZZLES_IN_FLIGHT; ++slot){
+        for (iter = 1; iter < nprocs && next < puzzles->count; ++iter){
+            next = send_puzzles(puzzles, next, slaves, iter, chunks + ((size_t) iter * PUZZLES_IN_FLIGHT + slot) * bytes,
+                                &requests[iter][slot]);
+            outstanding[iter]++;
+            sent[iter]++;
+        }
+    }
+    for (iter = 1; iter < nprocs; ++iter){
+        if (outstanding[iter] > 0){
+            running++;
+        } else {
+            MPI_Send(0, 0, MPI_INT, iter, STOP_WORK, WORLD);
+        }
+    }
+
+    MPI_Status status;
+    int first, count, source;
+    while (running > 0){
+        MPI_Recv(inbox, bytes, MPI_BYTE, MPI_ANY_SOURCE, ASK_FOR_WORK, WORLD, &status);
+        memcpy(&first, inbox, sizeof(int));
+        memcpy(&count, inbox + sizeof(int), sizeof(int));
+        memcpy(puzzles->solved + first, inbox + 2 * sizeof(int), count);
+        memcpy(puzzles_solution(puzzles, first), inbox + 2 * sizeof(int) + count, (size_t) count * size);
+
+        // chunks come back in the order they were sent, the buffer of the one answered is free
+        source = status.MPI_SOURCE;
+        outstanding[source]--;
+        if (next < puzzles->count){
+            slot = sent[source] % PUZZLES_IN_FLIGHT;
+            next = send_puzzles(puzzles, next, slaves, source, chunks + ((size_t) source * PUZZLES_IN_FLIGHT + slot) * bytes,
+                                &requests[source][slot]);
+            outstanding[source]++;
+            sent[source]++;
+        } else if (outstanding[source] == 0){
+            MPI_Send(0, 0, MPI_INT, source, STOP_WORK, WORLD);
+            running--;
+        }
+    }
+    for (iter = 1; iter < nprocs; ++iter){
+        MPI_Waitall(PUZZLES_IN_FLIGHT, requests[iter], MPI_STATUSES_IGNORE);
+    }
+    secs += MPI_Wtime();
+
+    puzzles_report(stdout, puzzles, &_options_, secs);
+    fflush(stdout);
+    if (_options_.stats == STATS_JSON) {
+        report_stats(puzzles_solved(puzzles) == puzzles->count, secs);
+    }
+
+    free(chunks);
+    free(inbox);
+    puzzles_free(puzzles);
+    free_buffers();
+}
+
+/**
+ * Slave of the batch mode. It solves the chunks of puzzles of the master
+ * in the order they come and sends back the solutions of every one, until
+ * the master has no puzzle left.
+ */
+void slave_batch() {
+    int root_n;
+    MPI_Bcast(&root_n, 1, MPI_INT, 0, WORLD);
+    Puzzles * puzzles = puzzles_create(root_n, PUZZLES_CHUNK_MAX);
+    int size = puzzles->n * puzzles->n;
+    int bytes = 2 * sizeof(int) + PUZZLES_CHUNK_MAX * (size + 1);
+    uint8_t * message = malloc(bytes);
+
+    MPI_Status status;
+    int count;
+    while (true){
+        MPI_Recv(message, bytes, MPI_BYTE, 0, MPI_ANY_TAG, WORLD, &status);
+        if (status.MPI_TAG == STOP_WORK){
+            break;
+        }
+        // the index of the first puzzle stays in the message, the solutions go back with it
+        memcpy(&count, message + sizeof(int), sizeof(int));
+        memcpy(puzzles->cells, message + 2 * sizeof(int), (size_t) count * size);
+        puzzles->count = count;
+        solve_puzzles(puzzles);
+        memcpy(message + 2 * sizeof(int), puzzles->solved, count);
+        memcpy(message + 2 * sizeof(int) + count, puzzles->solutions, (size_t) count * size);
+        MPI_Send(message, 2 * sizeof(int) + count * (size + 1), MPI_BYTE, 0, ASK_FOR_WORK, WORLD);
+    }
+
+    if (_options_.stats == STATS_JSON) {
+        report_stats(false, 0);
+    }
+    free(message);
+    puzzles_free(puzzles);
+    free_buffers();
+}
+
+/**
+ * Sends a slave the next chunk of puzzles of a batch: at most its share of
+ * the puzzles left split PUZZLES_SHARE ways, and at least one. The message
+ * is the index of the first puzzle, the number of puzzles and their cells.
+ *
+ * @param puzzles Puzzles of the batch.
+ * @param first Index of the first puzzle not sent yet.
+ * @param slaves Number of slaves.
+ * @param rank Rank to send to.
+ * @param message Buffer of the message, kept until the chunk is answered.
+ * @param request Request of the last send from the buffer, waited for before it is reused.
+ * @return Returns the index of the first puzzle after the chunk.
+ */
+int send_puzzles(Puzzles * puzzles, int first, int slaves, int rank, uint8_t * message, MPI_Request * request){
+    int size = puzzles->n * puzzles->n;
+    int count = (puzzles->count - first) / (PUZZLES_SHARE * slaves);
+    count = count < 1 ? 1 : count > PUZZLES_CHUNK_MAX ? PUZZLES_CHUNK_MAX : count;
+
+    MPI_Wait(request, MPI_STATUS_IGNORE);
+    memcpy(message, &first, sizeof(int));
+    memcpy(message + sizeof(int), &count, sizeof(int));
+    memcpy(message + 2 * sizeof(int), puzzles_cells(puzzles, first), (size_t) count * size);
+    MPI_Isend(message, 2 * sizeof(int) + count * size, MPI_BYTE, rank, START_WORK, WORLD, request);
+    return first + count;
+}
+
+/**
+ * Solves every puzzle of a batch, with every thread of the rank in the
+ * hybrid build, each taking the next few puzzles not started yet like the
+ * threads of the OpenMP version.
+ *
+ * @param puzzles Puzzles to solve.
+ */
+void solve_puzzles(Puzzles * puzzles){
+    int index;
+#ifdef _OPENMP
+    Stats total;
+    stats_clear(&total);
+    #pragma omp parallel
+    {
+        Stats stats;
+        stats_clear(&stats);
+        if (_scratch_ == NULL){
+            _scratch_ = puzzles_scratch_create();
+        }
+        #pragma omp for schedule(dynamic, puzzles_chunk(puzzles->count, omp_get_num_threads()))
+        for (index = 0; index < puzzles->count; ++index){
+            puzzles_solve(puzzles, index, _scratch_, &_options_, &stats);
+        }
+        #pragma omp critical
+        stats_add(&total, &stats);
+    }
+    stats_add(&_stats_, &total);
+#else
+    if (_scratch_ == NULL){
+        _scratch_ = puzzles_scratch_create();
+    }
+    for (index = 0; index < puzzles->count; ++index){
+        puzzles_solve(puzzles, index, _scratch_, &_options_, &_stats_);
+    }
+#endif
+}
@@ -7,6 +7,22 @@
 #include <string.h>
 #include <omp.h>
 #include <math.h>
+#include <limits.h>
+#include <sched.h>
+
+#include "affinity.h"
+#include "board.h"
+#include "checkpoint.h"
+#include "constraints.h"
+#include "dlx.h"
+#include "frontier.h"
+#include "kernel.h"
+#include "options.h"
+#include "pool.h"
+#include "puzzles.h"
+#include "scheduler.h"
+#include "search.h"
+#include "stats.h"
 
 
 ////////////////////////////////////////////////////////////
@@ -16,14 +32,35 @@ struct Puzzle {
 	int root_n;
 	int depth;
 	int n;
-	int ** matrix;
+	Board * board;
+	Constraints * constraints;
+	Trail * trail;
+	// pool of the snapshot, NULL if the puzzle was allocated on its own
+	Pool * pool;
 };
 
+/**
+ * State every worker thread keeps across the nodes it searches.
+ */
+struct Worker {
+	// snapshots of the nodes split off by the worker
+	Pool * pool;
+	// search reused for every node
+	Search * search;
+	// with checkpoints: the untried branches of its node when it paused for one, the
+	// number of the last one it paused for, INT_MAX once it stopped searching
+	Checkpoint * saved;
+	int paused;
+	// with checkpoints: limit of the branches its search hands to the kernel
+	LeafCutoff leaf;
+} __attribute__((aligned(64)));
+
 
 ////////////////////////////////////////////////////////////
 //// Types
 ////////////////////////////////////////////////////////////
 typedef struct Puzzle Puzzle;
+typedef struct Worker Worker;
 typedef int bool;
 
 
@@ -34,6 +71,8 @@ typedef int bool;
 #define true 1
 // get the size of elements on an array
 #define NELEMS(x)  (sizeof(x) / sizeof((x)[0]))
+// branches a worker searches between two checks for a split
+#define SPLIT_INTERVAL 64
 
 
 ////////////////////////////////////////////////////////////
@@ -41,11 +80,40 @@ typedef int bool;
 ////////////////////////////////////////////////////////////
 static double _start_;
 static double _end_;
-static int _offset_ = 10;
-static bool _time_flag_ = false;
-static bool _time_only_flag_ = false;
+// time the solution was found at
+static double _found_;
+// set once a solution is found, every worker stops at its next check
+static int _cancelled_ = 0;
+// copy of the solution, set by the worker that cancelled the search
+static Board * _solution_ = NULL;
+static Options _options_;
+// deques of the workers of the backtracking search
+static Scheduler * _scheduler_ = NULL;
+// state of every worker of the backtracking search
+static Worker * _workers_ = NULL;
+// processors the threads are pinned to, NULL if they are left unbound
+static Affinity * _affinity_ = NULL;
+// tasks spawned and not finished yet, only read and changed atomically
 static int _tasks_in_process_ = 0;
-static int _states_searched_ = 0;
+// tasks allowed in flight at once
+static int _task_limit_ = 0;
+// empty cells at or below which a branch is never spawned
+static int _cutoff_ = 0;
+// empty cells of the puzzle when the search starts
+static int _root_open_ = 0;
+// search counters of every thread, each changed only by its own thread
+static Stats * _stats_ = NULL;
+static int _threads_ = 0;
+// subproblems of the puzzle every worker pushes its share of, NULL once the search runs
+static Frontier * _frontier_ = NULL;
+// subproblems read with --resume, then those of the last checkpoint, NULL without checkpoints
+static Checkpoint * _checkpoint_ = NULL;
+// number of the checkpoint the workers pause for, 0 when none is being written,
+// only read and changed atomically
+static int _pausing_ = 0;
+// checkpoints written so far and time the next one is due, only used by worker 0
+static int _checkpoints_ = 0;
+static double _next_checkpoint_ = 0;
 
 ////////////////////////////////////////////////////////////
 //// Function Prototypes  
@@ -57,10 +125,37 @@ bool check_column(Puzzle * puzzle, int column, int number);
 bool check_row(Puzzle * puzzle, int row, int number);
 bool is_valid(Puzzle * puzzle, int row, int column, int number);
 bool find_empty(Puzzle * puzzle, int * row, int * column);
-bool solve(Puzzle * puzzle);
+bool select_cell(Puzzle * puzzle, int * row, int * column);
+bool load_constraints(Puzzle * puzzle);
+void store_values(Puzzle * puzzle);
+void work(Scheduler * scheduler, int worker);
+bool solve(Puzzle * puzzle, int worker);
+void split(Search * search, Puzzle * puzzle, int worker);
+int solve_leaf(Search * search, int cell, int number, void * data);
+void push_frontier(Puzzle * puzzle, int worker, int threads);
+void resume_nodes(Puzzle * puzzle, int threads);
+void pause_for_checkpoint(int worker, Search * search, Puzzle * puzzle);
+void write_checkpoint(int epoch);
+Puzzle * take_snapshot(Worker * worker, int root_n);
+void release_puzzle(Worker * worker, Puzzle * puzzle);
+void release_snapshot(void * block);
+int snapshots_peak();
+int spawn_threshold(int queued);
+bool reserve_task(int open);
+void release_task();
+int count_empty(Puzzle * puzzle);
+bool solve_scan(Puzzle * puzzle);
+void branch(Puzzle * puzzle, int row, int col, int number, int depth);
+bool solve_dlx(Puzzle * puzzle);
+bool solve_dlx_parallel(Puzzle * puzzle);
 Puzzle * copy(Puzzle * puzzle);
 void cleanPuzzle(Puzzle * puzzle);
-void end_on_solution_found(Puzzle * puzzle);
+void found_solution(Puzzle * puzzle);
+int cancelled(void * data);
+Stats * thread_stats();
+long states_searched();
+void print_result();
+void solve_batch();
 
 
 ////////////////////////////////////////////////////////////
@@ -79,26 +174,20 @@ int main(int argc, char *argv[]){
 	_start_ = omp_get_wtime();
 
 	FILE * file_input;
-	FILE * file_output;
 
 	char * filename;
 
 	// Check if file path was passed as an argument
-	if (argc > 4){
-		printf("ERROR: Too many arguments.\n");
-		exit(EXIT_FAILURE);
-	} else if (argc < 2) {
-		printf("ERROR: Missing arguments.\n");
+	if (!options_parse(&_options_, argc, argv)){
 		exit(EXIT_FAILURE);
-	} else if(argc == 3 && strcmp(argv[2], "-to") == 0) {
-        _time_only_flag_ = true;
-    } else if(argc == 3 && strcmp(argv[2], "-t") == 0) {
-        _time_flag_ = true;
-    }  else if(argc > 3 && (strcmp(argv[2], "-to") == 0 || strcmp(argv[3], "-to") == 0)) {
-        _time_only_flag_ = true;
-    } 
+	}
+
+	if (_options_.batch){
+		solve_batch();
+		return EXIT_SUCCESS;
+	}
 
-	filename = argv[1];
+	filename = _options_.filename;
 
 	// Open file in read mode
 	if ((file_input = fopen(filename,"r")) == NULL){
@@ -106,72 +195,145 @@ int main(int argc, char *argv[]){
 		exit(EXIT_FAILURE);
 	}
 
-	// Number of rows and columns
-	int n;
-	// Square root of n
-	int root_n;
-
-	// Read first line from the file to get n
-	fscanf(file_input, "%d\n", &root_n);
-
-	n = root_n * root_n;
+	// Read the board from the file
+	Board * board = board_read(file_input);
+	fclose(file_input);
+	if (board == NULL){
+		printf("ERROR: Could not read puzzle from file %s\n", filename);
+		exit(EXIT_FAILURE);
+	}
 
 	// ======================================
 	/** Initialize puzzle data structure */
-
-	// Puzzle matrix N x N
 	Puzzle * puzzle = malloc(sizeof(Puzzle));
-	puzzle->n = n;
-	puzzle->root_n = root_n;
+	puzzle->n = board->n;
+	puzzle->root_n = board->root_n;
 	puzzle->depth = 1;
-	puzzle->matrix = (int**) malloc(n * sizeof(int*));
-    int i;
-	for (i = 0; i < n; ++i){
-		puzzle->matrix[i] = (int * )malloc(n * sizeof(int));
-	}
-
-	// Read matrix from the file
-	int cursor;
-	int row = 0, col = 0, j;
-	for (i = 0; i < n; ++i){
-		
-		for (j = 0; j < n; ++j){
-			fscanf(file_input,"%d",&puzzle->matrix[i][j]);
-		}
-		fscanf(file_input, "\n");
-	}
+	puzzle->board = board;
+	puzzle->pool = NULL;
 	// ======================================
 
-	// Close file
-	fclose(file_input);
-
 
     //////////////////////////////////////////////////////////
     ////// START
     //////////////////////////////////////////////////////////
     //omp_set_num_threads(2);
+    _affinity_ = affinity_create(_options_.bind);
 
     // initialize threads
     #pragma omp parallel
     {
         //printf("nº threads: %d\n", omp_get_num_threads());
-        // only one of the threads initiate the solve method
+        // pinned before it allocates anything, so its memory is first touched on its node
+        affinity_pin(_affinity_, omp_get_thread_num());
+        // only one of the threads sets the search up
         #pragma omp single
         {
-            if(!solve(puzzle)){
-                // if no solution was found
-	            _end_ = omp_get_wtime();
-                if (_time_only_flag_) {
-                    printf("Elapsed time: %f (s)\n", _end_ - _start_);
-                } else if (_time_flag_) {
-                    printf("No solution\n");
-                    printf("Searched %d states in total.\n", _states_searched_);
-                    printf("Elapsed time: %f (s)\n", _end_ - _start_);
-                } else {
-                    printf("No solution\n");
+            int threads = omp_get_num_threads();
+            _threads_ = threads;
+            _stats_ = aligned_alloc(STATS_ALIGNMENT, threads * sizeof(Stats));
+            int thread;
+            for (thread = 0; thread < threads; ++thread){
+                stats_clear(&_stats_[thread]);
+            }
+            // saved before propagation fills the board, a checkpoint belongs to the puzzle as read
+            bool resumed = false;
+            if (_options_.checkpoint != NULL && _options_.engine == ENGINE_BACKTRACK && constraints_supported(puzzle->n)){
+                _checkpoint_ = checkpoint_create(puzzle->board);
+                int read = _options_.resume ? checkpoint_read(_checkpoint_, _options_.checkpoint) : CHECKPOINT_MISSING;
+                if (read == CHECKPOINT_INVALID){
+                    printf("ERROR: Could not resume from checkpoint %s\n", _options_.checkpoint);
+                    exit(EXIT_FAILURE);
+                }
+                resumed = read == CHECKPOINT_READ;
+                _next_checkpoint_ = omp_get_wtime() + _options_.checkpoint_interval;
+            }
+            bool solved = load_constraints(puzzle);
+            // a single thread has no one to hand work to
+            _task_limit_ = threads > 1 ? threads * _options_.tasks : 0;
+            _cutoff_ = _options_.cutoff >= 0 ? _options_.cutoff : puzzle->n;
+            _root_open_ = count_empty(puzzle);
+
+            if (solved && resumed){
+                // every worker starts with a share of the subproblems saved, a run stopped
+                // before its first checkpoint saved none and starts over below
+                _workers_ = aligned_alloc(64, threads * sizeof(Worker));
+                _scheduler_ = scheduler_create(threads, _task_limit_ + threads + _checkpoint_->count / threads + 1);
+                // like the frontier, the subproblems saved are queued on top of the tasks
+                _task_limit_ += threads > 1 ? _checkpoint_->count : 0;
+                resume_nodes(puzzle, threads);
+            } else if (solved && puzzle->constraints != NULL && _options_.engine == ENGINE_BACKTRACK){
+                // every worker searches from the deques, starting with a share of the frontier of the puzzle
+                _frontier_ = frontier_expand(puzzle->board, &_options_, threads);
+                _scheduler_ = scheduler_create(threads, _task_limit_ + threads + _frontier_->count / threads + 1);
+                // the frontier is queued on top of the tasks, so it does not fill the queue by itself
+                _task_limit_ += threads > 1 ? _frontier_->count : 0;
+                _workers_ = aligned_alloc(64, threads * sizeof(Worker));
+                if (_frontier_->solved){
+                    memcpy(puzzle->board->cells, _frontier_->solution, puzzle->n * puzzle->n);
+                    found_solution(puzzle);
+                }
+            } else if (solved){
+                // waits for every task spawned by the search
+                #pragma omp taskgroup
+                {
+                    solved = _options_.engine == ENGINE_DLX ? solve_dlx_parallel(puzzle) : solve_scan(puzzle);
+                    if (solved){
+                        // the solution was found without the help of other tasks
+                        found_solution(puzzle);
+                    }
                 }
-        	}
+            }
+        }
+
+        if (_scheduler_ != NULL){
+            int worker = omp_get_thread_num();
+            // every worker gets its snapshots from a pool of its own, on its own node
+            _workers_[worker].pool = pool_create(sizeof(Puzzle), release_snapshot);
+            _workers_[worker].search = NULL;
+            _workers_[worker].saved = _checkpoint_ != NULL ? checkpoint_create(_checkpoint_->given) : NULL;
+            _workers_[worker].paused = 0;
+            checkpoint_leaf_init(&_workers_[worker].leaf, _cutoff_, _options_.checkpoint_interval);
+            scheduler_place(_scheduler_, worker, affinity_socket(_affinity_, worker));
+            if (_frontier_ != NULL){
+                push_frontier(puzzle, worker, omp_get_num_threads());
+            }
+            #pragma omp barrier
+            work(_scheduler_, worker);
+        }
+    }
+
+    // every worker has stopped, the result is printed once
+    _end_ = omp_get_wtime();
+    print_result();
+    board_free(_solution_);
+    free(_stats_);
+    affinity_free(_affinity_);
+    frontier_free(_frontier_);
+
+    cleanPuzzle(puzzle);
+    if (_checkpoint_ != NULL){
+        // nothing is left to resume
+        remove(_options_.checkpoint);
+        checkpoint_free(_checkpoint_);
+    }
+    if (_scheduler_ != NULL){
+        int worker;
+        Puzzle * node;
+        // nodes left in the deques after a solution, the frontier and resumed ones were not
+        // taken from a pool and are freed here, the others go back to theirs
+        for (worker = 0; worker < _scheduler_->workers; ++worker){
+            while ((node = scheduler_pop(_scheduler_, worker)) != NULL){
+                release_puzzle(&_workers_[worker], node);
+            }
+        }
+        for (worker = 0; worker < _scheduler_->workers; ++worker){
+            pool_free(_workers_[worker].pool);
+            search_free(_workers_[worker].search);
+            checkpoint_free(_workers_[worker].saved);
         }
+        free(_workers_);
+        scheduler_free(_scheduler_);
     }
 
 	return EXIT_SUCCESS;
@@ -186,14 +348,7 @@ void debug_puzzle(Puzzle * puzzle){
     #pragma omp critical 
     {
         if (puzzle != NULL) {
-            int n = puzzle->n;
-            int i, j;
-            for (i = 0; i < n; ++i){
-                for (j = 0; j < n; ++j){
-                    printf("%d ", puzzle->matrix[i][j]);
-                }
-                printf("\n");
-            }
+            board_print(stdout, puzzle->board);
         }
     }
 }
@@ -205,14 +360,7 @@ void debug_puzzle(Puzzle * puzzle){
  * @param puzzle Sudoku puzzle data structure.
  */
 void print_puzzle_to_file(FILE * file, Puzzle * puzzle){
-	int n = puzzle->n;
-    int i, j;
-	for (i = 0; i < n; ++i){
-		for (j = 0; j < n; ++j){
-			fprintf(file, "%d ", puzzle->matrix[i][j]);
-		}
-		fprintf(file, "\n");
-	}
+	board_print(file, puzzle->board);
 }
 
 /**
@@ -228,7 +376,7 @@ bool check_grid(Puzzle * puzzle, int row, int column, int number){
     int i, j;
     for (i = 0; i < puzzle->root_n; ++i){
         for (j = 0; j < puzzle->root_n; ++j){
-            if (puzzle->matrix[i + row][j + column] == number){
+            if (board_get(puzzle->board, i + row, j + column) == number){
                 return true;
             }
         }
@@ -247,7 +395,7 @@ bool check_grid(Puzzle * puzzle, int row, int column, int number){
 bool check_column(Puzzle * puzzle, int column, int number){
     int i;
     for (i = 0; i < puzzle->n; ++i){
-        if(puzzle->matrix[i][column] == number){
+        if(board_get(puzzle->board, i, column) == number){
                 return true;
         }
     }
@@ -265,7 +413,7 @@ bool check_column(Puzzle * puzzle, int column, int number){
 bool check_row(Puzzle * puzzle, int row, int number){
     int i;
     for (i = 0; i < puzzle->n; ++i){
-        if (puzzle->matrix[row][i] == number){
+        if (board_get(puzzle->board, row, i) == number){
             return true;
         }
     }
@@ -298,7 +446,7 @@ bool is_valid(Puzzle * puzzle, int row, int column, int number){
 bool find_empty(Puzzle * puzzle, int * row, int * column){
     for (*row = 0; *row < puzzle->n; (*row)++){
         for (*column = 0; *column < puzzle->n; (*column)++){
-            if (puzzle->matrix[*row][*column] == 0){
+            if (board_get(puzzle->board, *row, *column) == 0){
                 return true;
             }
         }
@@ -307,13 +455,568 @@ bool find_empty(Puzzle * puzzle, int * row, int * column){
 }
 
 /**
- * Attemp to solve the sudoku puzzle using backtracking.
+ * Selects the cell to branch on, either the first empty cell or, when the
+ * puzzle has a constraint state and the mrv branching was requested, the
+ * empty cell with the fewest candidates.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @param row Row number reference.
+ * @param column Column number reference.
+ * @return Returns true if the puzzle has an empty position.
+ */
+bool select_cell(Puzzle * puzzle, int * row, int * column){
+    if (puzzle->constraints == NULL || _options_.branching == BRANCH_FIRST){
+        return find_empty(puzzle, row, column);
+    }
+
+    int cell = constraints_select_cell(puzzle->constraints);
+    if (cell < 0){
+        return false;
+    }
+    *row = cell / puzzle->n;
+    *column = cell % puzzle->n;
+    return true;
+}
+
+/**
+ * Builds the constraint state of the puzzle from the values already placed
+ * and, unless disabled, fills the cells forced by propagation.
+ * Boards too wide for a mask are left without one and use the scan checks.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns false if two of the given values conflict or propagation finds no solution.
+ */
+bool load_constraints(Puzzle * puzzle){
+    puzzle->constraints = NULL;
+    puzzle->trail = NULL;
+    if (!constraints_supported(puzzle->n)){
+        return true;
+    }
+
+    Constraints * constraints = malloc(sizeof(Constraints));
+    constraints_init(constraints, puzzle->root_n);
+    puzzle->constraints = constraints;
+    puzzle->trail = trail_create();
+
+    int row, col;
+    for (row = 0; row < puzzle->n; ++row){
+        for (col = 0; col < puzzle->n; ++col){
+            int number = board_get(puzzle->board, row, col);
+            if (number == 0){
+                continue;
+            }
+            if (!(constraints_candidates(constraints, row, col) & mask_of(number))){
+                return false;
+            }
+            constraints_place(constraints, row, col, number);
+        }
+    }
+
+    if (_options_.propagation && !constraints_propagate(constraints, puzzle->trail)){
+        return false;
+    }
+    store_values(puzzle);
+    return true;
+}
+
+/**
+ * Copies the numbers placed on the constraint state into the board.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ */
+void store_values(Puzzle * puzzle){
+    memcpy(puzzle->board->cells, puzzle->constraints->values, puzzle->n * puzzle->n);
+}
+
+/**
+ * Loop of a worker thread: searches the node at the bottom of its deque, or
+ * steals the top of another deque when its own is empty, until every node
+ * was searched. Between two nodes it pauses while a checkpoint is written.
+ *
+ * @param scheduler Scheduler of the workers.
+ * @param worker Index of the worker thread.
+ */
+void work(Scheduler * scheduler, int worker) {
+    Stats * stats = thread_stats();
+    // time the worker ran out of nodes at, from the start it has none
+    double idle_since = omp_get_wtime();
+
+    // nodes left in the deques after a solution are released once every worker stopped
+    while (!scheduler_finished(scheduler) && !cancelled(NULL)){
+        pause_for_checkpoint(worker, NULL, NULL);
+        Puzzle * puzzle = scheduler_pop(scheduler, worker);
+        if (puzzle == NULL){
+            puzzle = scheduler_steal(scheduler, worker);
+            stats->stolen += puzzle != NULL;
+        }
+        if (puzzle == NULL){
+            if (idle_since < 0){
+                idle_since = omp_get_wtime();
+            }
+            // lets the workers with nodes run when there are fewer cores than threads
+            sched_yield();
+            continue;
+        }
+        if (idle_since >= 0){
+            stats->idle += omp_get_wtime() - idle_since;
+            idle_since = -1;
+        }
+        stats->executed++;
+
+        if (solve(puzzle, worker)){
+            found_solution(puzzle);
+        }
+        release_puzzle(&_workers_[worker], puzzle);
+        scheduler_done(scheduler);
+    }
+    if (idle_since >= 0){
+        stats->idle += omp_get_wtime() - idle_since;
+    }
+    // a checkpoint written from now on does not wait for the worker
+    if (_checkpoint_ != NULL){
+        checkpoint_clear(_workers_[worker].saved);
+        #pragma omp atomic write seq_cst
+        _workers_[worker].paused = INT_MAX;
+    }
+}
+
+/**
+ * Attemp to solve a node of the sudoku puzzle using backtracking. While the
+ * search runs its shallowest untried branches are split off to the deque of
+ * the worker for idle workers to steal. With checkpoints only nodes and
+ * branches below the leaf cutoff of the worker go to the kernel whole, so
+ * the search pauses often enough for one.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @param worker Index of the worker thread.
+ * @return Returns true if the sudoku has a solution.
+ */
+bool solve(Puzzle * puzzle, int worker) {
+    // nodes split off a search hold the number of their branch, not its consequences
+    if (_options_.propagation && !constraints_propagate(puzzle->constraints, puzzle->trail)){
+        return false;
+    }
+
+    Worker * self = &_workers_[worker];
+    // too small to be split at the current queue depth, the whole subtree runs on this worker
+    if (_options_.kernel && kernel_supported(puzzle->root_n) &&
+        puzzle->constraints->open_count <= spawn_threshold(scheduler_queued(_scheduler_)) &&
+        (_checkpoint_ == NULL || puzzle->constraints->open_count <= self->leaf.cutoff)){
+        bool solved = kernel_solve(puzzle->root_n, puzzle->constraints->values, &_options_, thread_stats(), cancelled, NULL);
+        if (solved){
+            store_values(puzzle);
+        }
+        return solved;
+    }
+
+    if (self->search == NULL){
+        self->search = search_create(puzzle->constraints, puzzle->trail, &_options_);
+    } else {
+        search_init(self->search, puzzle->constraints, puzzle->trail, &_options_);
+    }
+    Search * search = self->search;
+    if (_checkpoint_ != NULL){
+        search->spawn = solve_leaf;
+        search->data = puzzle;
+    }
+    checkpoint_leaf_start(&self->leaf);
+    int status;
+    while ((status = search_run(search, SPLIT_INTERVAL)) == SEARCH_SUSPENDED && !cancelled(NULL) && !self->leaf.solved){
+        split(search, puzzle, worker);
+        if (_checkpoint_ != NULL){
+            checkpoint_leaf_slice(&self->leaf, search);
+            pause_for_checkpoint(worker, search, puzzle);
+        }
+    }
+    Stats * stats = thread_stats();
+    stats->nodes += search->states;
+    stats->backtracks += search->backtracks;
+    stats->propagations += search->propagations;
+
+    if (status == SEARCH_SOLVED){
+        store_values(puzzle);
+    }
+    // a branch solved by the kernel is already on the board
+    return status == SEARCH_SOLVED || self->leaf.solved;
+}
+
+/**
+ * Moves the shallowest untried branch of a search to the deque of its
+ * worker, if the deque is empty and the spawn policy allows the branch.
+ * 
+ * @param search Suspended search of the worker.
+ * @param puzzle Sudoku puzzle data structure being searched.
+ * @param worker Index of the worker thread.
+ */
+void split(Search * search, Puzzle * puzzle, int worker) {
+    if (scheduler_size(_scheduler_, worker) > 0){
+        return;
+    }
+    int threshold = spawn_threshold(scheduler_queued(_scheduler_));
+    if (threshold == INT_MAX){
+        return;
+    }
+
+    Worker * self = &_workers_[worker];
+    Puzzle * successor = take_snapshot(self, puzzle->root_n);
+    int cell, number;
+    int depth = search_split(search, threshold, successor->constraints, &cell, &number);
+    if (depth < 0){
+        pool_put(self->pool, successor);
+        return;
+    }
+
+    // the node is searched, propagated first, by whichever worker takes it
+    successor->depth = puzzle->depth + depth + 1;
+    constraints_assign(successor->constraints, successor->trail, cell / puzzle->n, cell % puzzle->n, number);
+    thread_stats()->spawned += scheduler_push(_scheduler_, worker, successor);
+}
+
+/**
+ * Spawn hook of the searches when checkpoints are written: a branch leaving
+ * few enough empty cells is searched whole by the kernel, which copies the
+ * solution into the board of the node if it finds one. The leaf cutoff of
+ * the worker follows the time the kernel takes, as in the serial solver.
+ *
+ * @param search Search trying the branch.
+ * @param cell Cell of the branch.
+ * @param number Number of the branch.
+ * @param data Sudoku puzzle data structure being searched.
+ * @return Returns non-zero if the branch was taken out of the search.
+ */
+int solve_leaf(Search * search, int cell, int number, void * data){
+    Puzzle * puzzle = data;
+    Worker * self = &_workers_[omp_get_thread_num()];
+    return checkpoint_leaf_solve(&self->leaf, search, cell, number, puzzle->board->cells, &_options_, thread_stats(),
+                                 cancelled, NULL);
+}
+
+/**
+ * Pushes the share of a worker of the frontier of the puzzle, every thread
+ * one subproblem in turn, on its own deque. Called by every worker before
+ * the search starts, so the constraint states of its subproblems are first
+ * touched on its own node. Pushed last to first, every worker starts with
+ * its first subproblem in the order of the expansion. The nodes are not
+ * taken from a pool, those still queued after a solution are freed with the
+ * deques once every worker stopped.
+ *
+ * @param puzzle Sudoku puzzle data structure, as read from its file.
+ * @param worker Index of the worker thread.
+ * @param threads Number of worker threads.
+ */
+void push_frontier(Puzzle * puzzle, int worker, int threads){
+    int item;
+    for (item = _frontier_->count - 1; item >= 0; --item){
+        if (item % threads != worker){
+            continue;
+        }
+        Puzzle * node = malloc(sizeof(Puzzle));
+        node->n = puzzle->n;
+        node->root_n = puzzle->root_n;
+        node->depth = puzzle->depth + _frontier_->depths[item];
+        node->board = board_create(puzzle->root_n);
+        node->pool = NULL;
+        memcpy(node->board->cells, frontier_cells(_frontier_, item), puzzle->n * puzzle->n);
+        if (!load_constraints(node)){
+            // the expansion already propagated it, but a dead subproblem is never searched
+            cleanPuzzle(node);
+            continue;
+        }
+        scheduler_push(_scheduler_, worker, node);
+        thread_stats()->spawned++;
+    }
+}
+
+/**
+ * Pushes the subproblems read from the checkpoint file, round robin over the
+ * deques and last to first like the frontier. Subproblems propagation finds
+ * no solution for are dropped. The checkpoint is emptied, it holds the next
+ * one written. The nodes are not taken from a pool, those still queued
+ * after a solution are freed with the deques once every worker stopped.
+ *
+ * @param puzzle Sudoku puzzle data structure, as read from its file.
+ * @param threads Number of worker threads.
+ */
+void resume_nodes(Puzzle * puzzle, int threads){
+    Puzzle ** nodes = malloc(_checkpoint_->count * sizeof(Puzzle *));
+    size_t offset = 0;
+    int count = 0, depth;
+    Puzzle * node = NULL;
+    while (true){
+        if (node == NULL){
+            node = malloc(sizeof(Puzzle));
+            node->n = puzzle->n;
+            node->root_n = puzzle->root_n;
+            node->board = board_create(puzzle->root_n);
+            node->constraints = NULL;
+            node->trail = NULL;
+            node->pool = NULL;
+        }
+        if (!checkpoint_next(_checkpoint_, &offset, node->board->cells, &depth)){
+            break;
+        }
+        node->depth = puzzle->depth + depth;
+        bool loaded = load_constraints(node);
+        if (loaded){
+            nodes[count++] = node;
+            node = NULL;
+        } else {
+            free(node->constraints);
+            trail_free(node->trail);
+            node->constraints = NULL;
+            node->trail = NULL;
+        }
+    }
+    cleanPuzzle(node);
+
+    int item;
+    for (item = count - 1; item >= 0; --item){
+        scheduler_push(_scheduler_, item % threads, nodes[item]);
+    }
+    thread_stats()->spawned += count;
+    free(nodes);
+    checkpoint_clear(_checkpoint_);
+}
+
+/**
+ * Safe point of a worker for checkpoints, reached between two nodes and
+ * between two slices of a search. Worker 0 starts a checkpoint once the
+ * interval is over; every worker then saves the untried branches of its
+ * search and waits until the checkpoint is written, worker 0 writes it.
+ * Without a checkpoint due it is one atomic read.
+ *
+ * @param worker Index of the worker thread.
+ * @param search Suspended search of the worker, NULL between two nodes.
+ * @param puzzle Sudoku puzzle data structure being searched, NULL between two nodes.
+ */
+void pause_for_checkpoint(int worker, Search * search, Puzzle * puzzle){
+    if (_checkpoint_ == NULL){
+        return;
+    }
+    int epoch;
+    #pragma omp atomic read seq_cst
+    epoch = _pausing_;
+    if (epoch == 0){
+        if (worker != 0 || omp_get_wtime() < _next_checkpoint_){
+            return;
+        }
+        epoch = ++_checkpoints_;
+        #pragma omp atomic write seq_cst
+        _pausing_ = epoch;
+    }
+
+    Worker * self = &_workers_[worker];
+    checkpoint_clear(self->saved);
+    if (search != NULL){
+        checkpoint_add_search(self->saved, search, puzzle->depth - 1);
+    }
+    if (worker == 0){
+        write_checkpoint(epoch);
+        return;
+    }
+
+    #pragma omp atomic write seq_cst
+    self->paused = epoch;
+    int current = epoch;
+    while (current == epoch && !cancelled(NULL)){
+        sched_yield();
+        #pragma omp atomic read seq_cst
+        current = _pausing_;
+    }
+}
+
+/**
+ * Writes a checkpoint once every other worker paused for it or stopped
+ * searching: the branches the workers saved and the nodes in the deques,
+ * then lets the workers go on. Called by worker 0, nothing is written if a
+ * solution is found meanwhile.
+ *
+ * @param epoch Number of the checkpoint.
+ */
+void write_checkpoint(int epoch){
+    int worker, index, paused;
+    for (worker = 1; worker < _threads_; ++worker){
+        #pragma omp atomic read seq_cst
+        paused = _workers_[worker].paused;
+        while (paused < epoch && !cancelled(NULL)){
+            sched_yield();
+            #pragma omp atomic read seq_cst
+            paused = _workers_[worker].paused;
+        }
+    }
+
+    if (!cancelled(NULL)){
+        checkpoint_clear(_checkpoint_);
+        for (worker = 0; worker < _threads_; ++worker){
+            Checkpoint * saved = _workers_[worker].saved;
+            checkpoint_append(_checkpoint_, saved->items, saved->size);
+            for (index = 0; index < scheduler_size(_scheduler_, worker); ++index){
+                Puzzle * node = scheduler_peek(_scheduler_, worker, index);
+                checkpoint_add(_checkpoint_, node->constraints->values, node->depth - 1);
+            }
+        }
+        if (!checkpoint_write(_checkpoint_, _options_.checkpoint)){
+            printf("WARNING: Could not write checkpoint %s\n", _options_.checkpoint);
+        }
+    }
+    _next_checkpoint_ = omp_get_wtime() + _options_.checkpoint_interval;
+    #pragma omp atomic write seq_cst
+    _pausing_ = 0;
+}
+
+/**
+ * Takes a puzzle snapshot out of the pool of a worker. A snapshot keeps the
+ * board, constraint state and trail it allocated on its first use, so once
+ * the pool has grown taking one does not allocate.
+ * 
+ * @param worker Worker taking the snapshot.
+ * @param root_n Square root of the size of the puzzle.
+ * @return Returns the snapshot, with an empty trail and its other contents undefined.
+ */
+Puzzle * take_snapshot(Worker * worker, int root_n) {
+    Puzzle * puzzle = pool_get(worker->pool);
+    if (puzzle->constraints == NULL){
+        puzzle->constraints = malloc(sizeof(Constraints));
+        puzzle->trail = trail_create();
+    }
+    if (puzzle->board == NULL || puzzle->board->root_n != root_n){
+        board_free(puzzle->board);
+        puzzle->board = board_create(root_n);
+    }
+    puzzle->root_n = root_n;
+    puzzle->n = root_n * root_n;
+    puzzle->depth = 1;
+    puzzle->trail->count = 0;
+    puzzle->pool = worker->pool;
+    return puzzle;
+}
+
+/**
+ * Gives a searched puzzle back to the pool it was taken from, or frees it
+ * if it was not taken from a pool.
+ * 
+ * @param worker Worker that searched the puzzle.
+ * @param puzzle Sudoku puzzle data structure.
+ */
+void release_puzzle(Worker * worker, Puzzle * puzzle) {
+    if (puzzle->pool == NULL){
+        cleanPuzzle(puzzle);
+    } else if (puzzle->pool == worker->pool){
+        pool_put(worker->pool, puzzle);
+    } else {
+        // stolen from another worker
+        pool_put_remote(puzzle->pool, puzzle);
+    }
+}
+
+/**
+ * Frees the buffers a snapshot allocated on its first use, called on every
+ * block of a pool when the pool is freed.
+ * 
+ * @param block Snapshot block of the pool.
+ */
+void release_snapshot(void * block) {
+    Puzzle * puzzle = block;
+    board_free(puzzle->board);
+    free(puzzle->constraints);
+    trail_free(puzzle->trail);
+}
+
+/**
+ * Number of snapshots the pools of every worker held at their peak.
+ * 
+ * @return Returns the sum of the peak of every pool.
+ */
+int snapshots_peak() {
+    int worker, peak = 0;
+    for (worker = 0; _workers_ != NULL && worker < _scheduler_->workers; ++worker){
+        if (_workers_[worker].pool != NULL){
+            peak += _workers_[worker].pool->peak;
+        }
+    }
+    return peak;
+}
+
+/**
+ * Empty cells a branch must leave for it to be worth a task, given the
+ * work already queued, tasks in flight or nodes in the deques. With no task queued every branch above the cutoff
+ * is spawned, as the queue fills up only branches closer to the root are,
+ * and none once it is full.
+ *
+ * @param queued Number of tasks in flight or nodes queued.
+ * @return Returns the number of empty cells a spawned branch must exceed.
+ */
+int spawn_threshold(int queued){
+    if (queued >= _task_limit_){
+        return INT_MAX;
+    }
+    int range = _root_open_ > _cutoff_ ? _root_open_ - _cutoff_ : 0;
+    return _cutoff_ + (int) ((long) range * queued / _task_limit_);
+}
+
+/**
+ * Takes a slot for a new task if the spawn policy allows a branch with the
+ * given number of empty cells. The queue is read before it is changed so
+ * refused branches, the common case, never write to the shared counter.
+ *
+ * @param open Number of empty cells left by the branch.
+ * @return Returns true if a task slot was taken, to be given back by release_task.
+ */
+bool reserve_task(int open){
+    int queued;
+    #pragma omp atomic read
+    queued = _tasks_in_process_;
+    if (open <= spawn_threshold(queued)){
+        return false;
+    }
+
+    // other threads may have taken the last slots since the read
+    #pragma omp atomic capture
+    queued = _tasks_in_process_++;
+    if (queued >= _task_limit_){
+        release_task();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Gives back the slot of a finished task.
+ */
+void release_task(){
+    #pragma omp atomic
+    _tasks_in_process_--;
+}
+
+/**
+ * Counts the empty cells of the puzzle.
+ *
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns the number of empty cells.
+ */
+int count_empty(Puzzle * puzzle){
+    if (puzzle->constraints != NULL){
+        return puzzle->constraints->open_count;
+    }
+    int cell, count = 0;
+    for (cell = 0; cell < puzzle->n * puzzle->n; ++cell){
+        count += puzzle->board->cells[cell] == 0;
+    }
+    return count;
+}
+
+/**
+ * Attemp to solve the sudoku puzzle using recursive backtracking over the
+ * matrix, checking every number with the row, column and grid scans.
  * 
  * @param puzzle Sudoku puzzle data structure.
  * @return Returns true if the sudoku has a solution.
  */
-bool solve(Puzzle * puzzle) {
-    _states_searched_ ++;
+bool solve_scan(Puzzle * puzzle) {
+    if (cancelled(NULL)){
+        return false;
+    }
+    thread_stats()->nodes++;
     int row = 0, col = 0;
     int depth = puzzle->depth;
 
@@ -324,57 +1027,122 @@ bool solve(Puzzle * puzzle) {
     
     int i;
 	for (i = 1; i <= puzzle->n; ++i){
-
 		// Check if number can be placed in a cell
 		if (is_valid(puzzle, row, col, i)){
-			puzzle->matrix[row][col] = i;
-            puzzle->depth = depth + 1;
-            bool should_copy = false;
-            #pragma omp critical 
-            {
-                // If there are too few tasks available
-                if(_tasks_in_process_ < omp_get_num_threads() - 1 && 
-                    puzzle->depth < _offset_){
-                    should_copy = true;
-                    _tasks_in_process_ ++;
-                } else {
-                    should_copy = false;
-                }
-            } 
- 
-            if(should_copy) {
-             
-                // creates a new copy of the sudoku puzzle
-                Puzzle * successor = copy(puzzle);
-                // creates a task
-                #pragma omp task default(shared) firstprivate(row, col, successor)
-                {
-                    
-                    //Proceeds with a copy as a task
-                    if (solve(successor)){
-                        end_on_solution_found(successor);
-        			}
-        			
-        			_tasks_in_process_ --;
-        			
-                }
-            } else {    // continues the program in serial mode
-                if (solve(puzzle)){
-    			    end_on_solution_found(puzzle);
-        		}
-            }
-            
-            // the value on the position didn't reach the solution, so change it to zero
-			puzzle->matrix[row][col] = 0;
-		}
-	}
+            branch(puzzle, row, col, i, depth);
+        }
+    }
 	
 	#pragma omp taskwait
 
+	thread_stats()->backtracks++;
 	return false;
 
 }
 
+/**
+ * Places a number in a cell and searches the resulting puzzle with the
+ * scans, either as a new task on a copy or serially on the puzzle itself.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @param row Row of the cell.
+ * @param col Column of the cell.
+ * @param number Number to place in the cell.
+ * @param depth Depth of the puzzle before the number is placed.
+ */
+void branch(Puzzle * puzzle, int row, int col, int number, int depth) {
+    board_set(puzzle->board, row, col, number);
+    puzzle->depth = depth + 1;
+
+    // every level of the scan search places one number
+    if (reserve_task(_root_open_ - depth)) {
+     
+        // creates a new copy of the sudoku puzzle
+        Puzzle * successor = copy(puzzle);
+        int creator = omp_get_thread_num();
+        thread_stats()->spawned++;
+        // creates a task
+        #pragma omp task default(shared) firstprivate(row, col, successor, creator)
+        {
+            Stats * stats = thread_stats();
+            stats->executed++;
+            stats->stolen += omp_get_thread_num() != creator;
+            //Proceeds with a copy as a task
+            if (solve_scan(successor)){
+                found_solution(successor);
+            }
+            cleanPuzzle(successor);
+            release_task();
+        }
+    } else {    // continues the program in serial mode
+        if (solve_scan(puzzle)){
+            found_solution(puzzle);
+        }
+    }
+    
+    // the value on the position didn't reach the solution, so change it to zero
+    board_set(puzzle->board, row, col, 0);
+}
+
+/**
+ * Attemp to solve the sudoku puzzle with the dancing links exact cover search.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns true if the sudoku has a solution.
+ */
+bool solve_dlx(Puzzle * puzzle) {
+    Dlx * dlx = dlx_create(puzzle->root_n, puzzle->board->cells);
+    if (dlx == NULL){
+        return false;
+    }
+    dlx->stop = cancelled;
+    bool solved = dlx_solve(dlx, puzzle->board->cells);
+    Stats * stats = thread_stats();
+    stats->nodes += dlx->states;
+    stats->backtracks += dlx->backtracks;
+    dlx_free(dlx);
+    return solved;
+}
+
+/**
+ * Expands the puzzle into its frontier and solves every subproblem with the
+ * dancing links search as a task.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns true if the puzzle was solved by the expansion, left in its board.
+ */
+bool solve_dlx_parallel(Puzzle * puzzle) {
+    Frontier * frontier = frontier_expand(puzzle->board, &_options_, omp_get_num_threads());
+    if (frontier->solved){
+        memcpy(puzzle->board->cells, frontier->solution, puzzle->n * puzzle->n);
+        frontier_free(frontier);
+        return true;
+    }
+
+    int i;
+    for (i = 0; i < frontier->count; ++i){
+        Puzzle * successor = copy(puzzle);
+        memcpy(successor->board->cells, frontier_cells(frontier, i), puzzle->n * puzzle->n);
+        int creator = omp_get_thread_num();
+        thread_stats()->spawned++;
+        #pragma omp task default(shared) firstprivate(successor, creator)
+        {
+            Stats * stats = thread_stats();
+            stats->executed++;
+            stats->stolen += omp_get_thread_num() != creator;
+            if (solve_dlx(successor)){
+                found_solution(successor);
+            }
+            cleanPuzzle(successor);
+        }
+    }
+
+    #pragma omp taskwait
+
+    frontier_free(frontier);
+    return false;
+}
+
 /**
  * Creates a new puzzle based on a puzzle received as argument.
  * 
@@ -390,15 +1158,10 @@ Puzzle * copy(Puzzle * puzzle) {
     copy_puzzle->root_n = puzzle->root_n;
     copy_puzzle->n = puzzle->n;
     copy_puzzle->depth = puzzle->depth;
-    copy_puzzle->matrix = (int**) malloc(puzzle->n * sizeof(int*));          // alloc space for matrix
-    int i,j;
-    // manual copy
-    for (i = 0; i < puzzle->n; ++i){
-        copy_puzzle->matrix[i] = (int * )malloc(puzzle->n * sizeof(int));    // alloc space
-        for (j = 0; j < puzzle->n; ++j){
-            copy_puzzle->matrix[i][j] = puzzle->matrix[i][j];                // copy values
-        }
-    }
+    copy_puzzle->constraints = constraints_copy(puzzle->constraints);
+    copy_puzzle->trail = puzzle->trail != NULL ? trail_create() : NULL;
+    copy_puzzle->board = board_copy(puzzle->board);
+    copy_puzzle->pool = NULL;
     return copy_puzzle;
 }
 
@@ -409,32 +1172,148 @@ Puzzle * copy(Puzzle * puzzle) {
  */
 void cleanPuzzle (Puzzle * puzzle) {
     if (puzzle != NULL) {
-        int n = puzzle->n;
-        int i;
-        // Free memory   
-        for (i = 0; i <  n ; i++){
-            free(puzzle->matrix[i]);
-        }
-        free(puzzle->matrix);
+        board_free(puzzle->board);
+        free(puzzle->constraints);
+        trail_free(puzzle->trail);
         free(puzzle);
     }
 }
 
 /**
- * Prints the sudoku puzzle solved and the time accordingly to the flags passed as arguments.
+ * Keeps a copy of a solution and cancels the search. Only the first
+ * solution found is kept, the workers still running stop at their next
+ * check of the cancellation flag.
  * 
- * @param puzzle Sudoku puzzle data structure.
+ * @param puzzle Sudoku puzzle data structure holding the solution.
  */
-void end_on_solution_found(Puzzle * puzzle) {
-    _end_ = omp_get_wtime();
-    if (_time_only_flag_) {
-        printf("Elapsed time: %f (s)\n", _end_ - _start_);
-    } else if (_time_flag_) {
-        debug_puzzle(puzzle);
-        printf("Searched %d states in total.\n", _states_searched_);
-        printf("Elapsed time: %f (s)\n", _end_ - _start_);
+void found_solution(Puzzle * puzzle) {
+    int was_cancelled;
+    #pragma omp atomic capture
+    { was_cancelled = _cancelled_; _cancelled_ = 1; }
+    if (!was_cancelled){
+        _found_ = omp_get_wtime();
+        _solution_ = board_copy(puzzle->board);
+    }
+}
+
+/**
+ * Stop hook of the searches, checked between search slices, every few
+ * states of the kernel and the dancing links search and on every state of
+ * the scan search.
+ * 
+ * @param data Unused.
+ * @return Returns non-zero once a solution was found.
+ */
+int cancelled(void * data) {
+    int stop;
+    (void) data;
+    #pragma omp atomic read
+    stop = _cancelled_;
+    return stop;
+}
+
+/**
+ * Counters of the calling thread.
+ * 
+ * @return Returns the counters only the calling thread changes.
+ */
+Stats * thread_stats() {
+    return &_stats_[omp_get_thread_num()];
+}
+
+/**
+ * Number of states searched by every thread.
+ * 
+ * @return Returns the sum of the states searched.
+ */
+long states_searched() {
+    long states = 0;
+    int thread;
+    for (thread = 0; thread < _threads_; ++thread){
+        states += _stats_[thread].nodes;
+    }
+    return states;
+}
+
+/**
+ * Prints the solution, or that there is none, the time and the statistics
+ * accordingly to the flags passed as arguments. Called once every worker
+ * has stopped.
+ */
+void print_result() {
+    double elapsed = (_solution_ != NULL ? _found_ : _end_) - _start_;
+    if (_options_.time_only_flag) {
+        printf("Elapsed time: %f (s)\n", elapsed);
     } else {
-        debug_puzzle(puzzle);
+        if (_solution_ != NULL) {
+            board_print(stdout, _solution_);
+        } else {
+            printf("No solution\n");
+        }
+        if (_options_.time_flag) {
+            printf("Searched %ld states in total.\n", states_searched());
+            printf("Peak of %d puzzle snapshots in the pools.\n", snapshots_peak());
+            if (_solution_ != NULL) {
+                printf("Workers stopped %f (s) after the solution was found.\n", _end_ - _found_);
+            }
+            printf("Elapsed time: %f (s)\n", elapsed);
+        }
+    }
+    if (_options_.stats == STATS_JSON) {
+        stats_print_json(stdout, "omp", _stats_, _threads_, _solution_ != NULL, elapsed);
     }
-    exit(EXIT_SUCCESS);
-}
\ No newline at end of file
+}
+
+/**
+ * Solves every puzzle of a batch file, one puzzle per thread at a time:
+ * the threads take the next few puzzles not started yet as they finish
+ * theirs, each with buffers of its own. The solutions are
+ * printed in the order of the file, followed by the puzzles solved per
+ * second.
+ */
+void solve_batch() {
+    FILE * file_input = fopen(_options_.filename, "r");
+    if (file_input == NULL){
+        printf("ERROR: Could not open file %s\n", _options_.filename);
+        exit(EXIT_FAILURE);
+    }
+    Puzzles * puzzles = puzzles_read(file_input);
+    fclose(file_input);
+    if (puzzles == NULL){
+        printf("ERROR: Could not read puzzles from file %s\n", _options_.filename);
+        exit(EXIT_FAILURE);
+    }
+
+    _affinity_ = affinity_create(_options_.bind);
+    #pragma omp parallel
+    {
+        affinity_pin(_affinity_, omp_get_thread_num());
+        #pragma omp single
+        {
+            _threads_ = omp_get_num_threads();
+            _stats_ = aligned_alloc(STATS_ALIGNMENT, _threads_ * sizeof(Stats));
+            int thread;
+            for (thread = 0; thread < _threads_; ++thread){
+                stats_clear(&_stats_[thread]);
+            }
+        }
+
+        PuzzlesScratch * scratch = puzzles_scratch_create();
+        Stats * stats = thread_stats();
+        int index;
+        #pragma omp for schedule(dynamic, puzzles_chunk(puzzles->count, omp_get_num_threads()))
+        for (index = 0; index < puzzles->count; ++index){
+            puzzles_solve(puzzles, index, scratch, &_options_, stats);
+        }
+        puzzles_scratch_free(scratch);
+    }
+    _end_ = omp_get_wtime();
+
+    puzzles_report(stdout, puzzles, &_options_, _end_ - _start_);
+    if (_options_.stats == STATS_JSON) {
+        stats_print_json(stdout, "omp", _stats_, _threads_, puzzles_solved(puzzles) == puzzles->count, _end_ - _start_);
+    }
+    free(_stats_);
+    affinity_free(_affinity_);
+    puzzles_free(puzzles);
+}
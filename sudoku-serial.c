@@ -1,10 +1,21 @@
 ////////////////////////////////////////////////////////////
 //// Includes
 ////////////////////////////////////////////////////////////
+#include <time.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "board.h"
+#include "checkpoint.h"
+#include "constraints.h"
+#include "dlx.h"
+#include "kernel.h"
+#include "options.h"
+#include "puzzles.h"
+#include "search.h"
+#include "stats.h"
+
 
 ////////////////////////////////////////////////////////////
 //// Structures
@@ -12,7 +23,9 @@
 struct Puzzle {
 	int root_n;
 	int n;
-	int ** matrix;
+	Board * board;
+	Constraints * constraints;
+	Trail * trail;
 };
 
 
@@ -28,6 +41,8 @@ typedef int bool;
 ////////////////////////////////////////////////////////////
 #define false 0
 #define true 1
+// branches searched between two looks at the clock when checkpoints are written
+#define CHECKPOINT_SLICE 64
 
 
 ////////////////////////////////////////////////////////////
@@ -35,7 +50,10 @@ typedef int bool;
 ////////////////////////////////////////////////////////////
 static double _start_;
 static double _end_;
-static int _states_searched_ = 0;
+static Stats _stats_;
+static Options _options_;
+// limit of the branches the search hands to the kernel when checkpoints are written
+static LeafCutoff _leaf_;
 
 ////////////////////////////////////////////////////////////
 //// Function Prototypes  
@@ -47,8 +65,16 @@ bool check_column(Puzzle * puzzle, int column, int number);
 bool check_row(Puzzle * puzzle, int row, int number);
 bool is_valid(Puzzle * puzzle, int row, int column, int number);
 bool find_empty(Puzzle * puzzle, int * row, int * column);
+bool load_constraints(Puzzle * puzzle);
+void store_values(Puzzle * puzzle);
 bool solve(Puzzle * puzzle);
-void end_on_solution_found(Puzzle * puzzle);
+bool solve_scan(Puzzle * puzzle);
+bool solve_dlx(Puzzle * puzzle);
+bool solve_resumable(Puzzle * puzzle);
+void solve_batch();
+int solve_leaf(Search * search, int cell, int number, void * data);
+void print_solution(Puzzle * puzzle);
+double wall_time();
 
 
 ////////////////////////////////////////////////////////////
@@ -64,6 +90,7 @@ void end_on_solution_found(Puzzle * puzzle);
  */
 int main(int argc, char *argv[]){
     // starts counter
+	_start_ = wall_time();
 
 	FILE * file_input;
 	FILE * file_output;
@@ -71,12 +98,16 @@ int main(int argc, char *argv[]){
 	char * filename;
 
 	// Check if file path was passed as an argument
-	if (argc > 2){
-		printf("ERROR: Too many arguments.\n");
+	if (!options_parse(&_options_, argc, argv)){
 		exit(EXIT_FAILURE);
-	} 
+	}
+
+	if (_options_.batch){
+		solve_batch();
+		return EXIT_SUCCESS;
+	}
 
-	filename = argv[1];
+	filename = _options_.filename;
 
 	// Open file in read mode
 	if ((file_input = fopen(filename, "r")) == NULL){
@@ -84,47 +115,35 @@ int main(int argc, char *argv[]){
 		exit(EXIT_FAILURE);
 	}
 
-	// Number of rows and columns
-	int n;
-	// Square root of n
-	int root_n;
-
-	// Read first line from the file to get n
-	fscanf(file_input, "%d\n", &root_n);
-
-	n = root_n * root_n;
+	// Read the board from the file
+	Board * board = board_read(file_input);
+	fclose(file_input);
+	if (board == NULL){
+		printf("ERROR: Could not read puzzle from file %s\n", filename);
+		exit(EXIT_FAILURE);
+	}
 
 	// ======================================
 	/** Initialize puzzle data structure */
-
-	// Puzzle matrix N x N
 	Puzzle * puzzle = malloc(sizeof(Puzzle));
-	puzzle->n = n;
-	puzzle->root_n = root_n;
-
-	puzzle->matrix = (int**) malloc(n * sizeof(int*));
-	int i;
-	for (i = 0; i < n; ++i){
-		puzzle->matrix[i] = (int * )malloc(n * sizeof(int));
-	}
-
+	puzzle->n = board->n;
+	puzzle->root_n = board->root_n;
+	puzzle->board = board;
+	// ======================================
 
-	// Read matrix from the file
-	int cursor;
-	int row = 0, col = 0;
-	int j;
-	for (i = 0; i < n; ++i){
-		for (j = 0; j < n; ++j){
-			fscanf(file_input, "%d", &puzzle->matrix[i][j]);
+	// the whole puzzle is the one work item of the serial solver
+	_stats_.executed = 1;
+	bool solved;
+	if (_options_.checkpoint != NULL && _options_.engine == ENGINE_BACKTRACK && constraints_supported(puzzle->n)){
+		solved = solve_resumable(puzzle);
+	} else {
+		solved = load_constraints(puzzle);
+		if (solved){
+			solved = _options_.engine == ENGINE_DLX ? solve_dlx(puzzle) : solve(puzzle);
 		}
-    		fscanf(file_input, "\n");
 	}
-	// ======================================
 
-	// Close file
-	fclose(file_input);
-	
-	if(solve(puzzle)){
+	if(solved){
 
 		/* Write solution to .out file. */
 		char * name_out;
@@ -141,19 +160,31 @@ int main(int argc, char *argv[]){
 		print_puzzle_to_file(file_output, puzzle);
 		// Close output file
 		fclose(file_output);
+		free(name_out);
     
-        end_on_solution_found(puzzle);
+        print_solution(puzzle);
 
 	} else {
-		printf("No solution\n");
+		_end_ = wall_time();
+		if (_options_.time_only_flag) {
+			printf("Elapsed time: %f (s)\n", _end_ - _start_);
+		} else if (_options_.time_flag) {
+			printf("No solution\n");
+			printf("Searched %ld states in total.\n", _stats_.nodes);
+			printf("Elapsed time: %f (s)\n", _end_ - _start_);
+		} else {
+			printf("No solution\n");
+		}
+	}
+	if (_options_.stats == STATS_JSON) {
+		stats_print_json(stdout, "serial", &_stats_, 1, solved, _end_ - _start_);
 	}
 
     // ======================================
     /** Free puzzle memory */
-	for (i = 0; i <  n ; ++i){
-		free(puzzle->matrix[i]);
-	}
-	free(puzzle->matrix);
+	board_free(puzzle->board);
+	free(puzzle->constraints);
+	trail_free(puzzle->trail);
 	free(puzzle);
     // ======================================
     
@@ -167,14 +198,7 @@ int main(int argc, char *argv[]){
 */
 void debug_puzzle(Puzzle * puzzle){
     if (puzzle != NULL) {
-        int n = puzzle->n;
-        int i, j;
-        for (i = 0; i < n; ++i){
-            for (j = 0; j < n; ++j){
-                printf("%d ", puzzle->matrix[i][j]);
-            }
-            printf("\n");
-        }
+        board_print(stdout, puzzle->board);
     }
 }
 
@@ -185,14 +209,7 @@ void debug_puzzle(Puzzle * puzzle){
  * @param puzzle Sudoku puzzle data structure.
  */
 void print_puzzle_to_file(FILE * file, Puzzle * puzzle){
-	int n = puzzle->n;
-    int i, j;
-	for (i = 0; i < n; ++i){
-		for (j = 0; j < n; ++j){
-			fprintf(file, "%d ", puzzle->matrix[i][j]);
-		}
-		fprintf(file, "\n");
-	}
+	board_print(file, puzzle->board);
 }
 
 /**
@@ -208,7 +225,7 @@ bool check_grid(Puzzle * puzzle, int row, int column, int number){
     int i, j;
 	for (i = 0; i < puzzle->root_n; ++i){
 		for (j = 0; j < puzzle->root_n; ++j){
-			if (puzzle->matrix[i + row][j + column] == number){
+			if (board_get(puzzle->board, i + row, j + column) == number){
 				return true;
 			}
 		}
@@ -227,7 +244,7 @@ bool check_grid(Puzzle * puzzle, int row, int column, int number){
 bool check_column(Puzzle * puzzle, int column, int number){
     int i;
 	for (i = 0; i < puzzle->n; i++){
-		if(puzzle->matrix[i][column] == number){
+		if(board_get(puzzle->board, i, column) == number){
 			return true;
 		}
 	}
@@ -245,7 +262,7 @@ bool check_column(Puzzle * puzzle, int column, int number){
 bool check_row(Puzzle * puzzle, int row, int number){
 	int i;
     for (i = 0; i < puzzle->n; ++i){
-		if (puzzle->matrix[row][i] == number){
+		if (board_get(puzzle->board, row, i) == number){
 			return true;
 		}
 	}
@@ -278,7 +295,7 @@ bool is_valid(Puzzle * puzzle, int row, int column, int number){
 bool find_empty(Puzzle * puzzle, int * row, int * column){
 	for (*row = 0; *row < puzzle->n; (*row)++){
 		for (*column = 0; *column < puzzle->n; (*column)++){
-			if (puzzle->matrix[*row][*column] == 0){
+			if (board_get(puzzle->board, *row, *column) == 0){
 				return true;
 			}
 		}
@@ -286,6 +303,56 @@ bool find_empty(Puzzle * puzzle, int * row, int * column){
 	return false;
 }
 
+/**
+ * Builds the constraint state of the puzzle from the values already placed
+ * and, unless disabled, fills the cells forced by propagation.
+ * Boards too wide for a mask are left without one and use the scan checks.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns false if two of the given values conflict or propagation finds no solution.
+ */
+bool load_constraints(Puzzle * puzzle){
+	puzzle->constraints = NULL;
+	puzzle->trail = NULL;
+	if (!constraints_supported(puzzle->n)){
+		return true;
+	}
+
+	Constraints * constraints = malloc(sizeof(Constraints));
+	constraints_init(constraints, puzzle->root_n);
+	puzzle->constraints = constraints;
+	puzzle->trail = trail_create();
+
+	int row, column;
+	for (row = 0; row < puzzle->n; ++row){
+		for (column = 0; column < puzzle->n; ++column){
+			int number = board_get(puzzle->board, row, column);
+			if (number == 0){
+				continue;
+			}
+			if (!(constraints_candidates(constraints, row, column) & mask_of(number))){
+				return false;
+			}
+			constraints_place(constraints, row, column, number);
+		}
+	}
+
+	if (_options_.propagation && !constraints_propagate(constraints, puzzle->trail)){
+		return false;
+	}
+	store_values(puzzle);
+	return true;
+}
+
+/**
+ * Copies the numbers placed on the constraint state into the board.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ */
+void store_values(Puzzle * puzzle){
+	memcpy(puzzle->board->cells, puzzle->constraints->values, puzzle->n * puzzle->n);
+}
+
 /**
  * Attemp to solve the sudoku puzzle using backtracking.
  * 
@@ -293,7 +360,138 @@ bool find_empty(Puzzle * puzzle, int * row, int * column){
  * @return Returns true if the sudoku has a solution.
  */
 bool solve(Puzzle * puzzle){
-    _states_searched_ ++;
+	// Boards too wide for a mask check every number with the scans
+	if (puzzle->constraints == NULL){
+		return solve_scan(puzzle);
+	}
+
+	if (_options_.kernel && kernel_supported(puzzle->root_n)){
+		bool solved = kernel_solve(puzzle->root_n, puzzle->constraints->values, &_options_, &_stats_, NULL, NULL);
+		if (solved){
+			store_values(puzzle);
+		}
+		return solved;
+	}
+
+	Search * search = search_create(puzzle->constraints, puzzle->trail, &_options_);
+	bool solved = search_run(search, 0) == SEARCH_SOLVED;
+	_stats_.nodes += search->states;
+	_stats_.backtracks += search->backtracks;
+	_stats_.propagations += search->propagations;
+	search_free(search);
+
+	if (solved){
+		store_values(puzzle);
+	}
+	return solved;
+}
+
+/**
+ * Attemp to solve the sudoku puzzle with a search that can be saved: the
+ * puzzle, or the subproblems of the checkpoint file with --resume, are
+ * searched one after the other, and every --checkpoint-interval seconds
+ * the untried branches of the search and the subproblems not started yet
+ * are written to the checkpoint file. Branches small enough are searched
+ * whole by the kernel, between two looks at the clock. The checkpoint file
+ * is removed once the search is over.
+ *
+ * @param puzzle Sudoku puzzle data structure, as read from its file.
+ * @return Returns true if the sudoku has a solution.
+ */
+bool solve_resumable(Puzzle * puzzle){
+	Checkpoint * work = checkpoint_create(puzzle->board);
+	int read = _options_.resume ? checkpoint_read(work, _options_.checkpoint) : CHECKPOINT_MISSING;
+	if (read == CHECKPOINT_INVALID){
+		printf("ERROR: Could not resume from checkpoint %s\n", _options_.checkpoint);
+		exit(EXIT_FAILURE);
+	}
+	if (read == CHECKPOINT_MISSING){
+		// a first run, or one stopped before its first checkpoint
+		checkpoint_add(work, puzzle->board->cells, 0);
+	}
+
+	Checkpoint * saved = checkpoint_create(puzzle->board);
+	Search * search = NULL;
+	double next = wall_time() + _options_.checkpoint_interval;
+	size_t offset = 0;
+	int depth, status = SEARCH_EXHAUSTED;
+	_stats_.executed = 0;
+	checkpoint_leaf_init(&_leaf_, _options_.cutoff >= 0 ? _options_.cutoff : puzzle->n, _options_.checkpoint_interval);
+	puzzle->constraints = NULL;
+	puzzle->trail = NULL;
+
+	while (status != SEARCH_SOLVED && !_leaf_.solved && checkpoint_next(work, &offset, puzzle->board->cells, &depth)){
+		_stats_.executed++;
+		free(puzzle->constraints);
+		trail_free(puzzle->trail);
+		if (!load_constraints(puzzle)){
+			status = SEARCH_EXHAUSTED;
+			continue;
+		}
+		if (search == NULL){
+			search = search_create(puzzle->constraints, puzzle->trail, &_options_);
+		} else {
+			search_init(search, puzzle->constraints, puzzle->trail, &_options_);
+		}
+		search->spawn = solve_leaf;
+		search->data = puzzle;
+
+		checkpoint_leaf_start(&_leaf_);
+		while ((status = search_run(search, CHECKPOINT_SLICE)) == SEARCH_SUSPENDED && !_leaf_.solved){
+			checkpoint_leaf_slice(&_leaf_, search);
+			if (wall_time() < next){
+				continue;
+			}
+			checkpoint_clear(saved);
+			checkpoint_add_search(saved, search, depth);
+			checkpoint_append(saved, work->items + offset, work->size - offset);
+			if (!checkpoint_write(saved, _options_.checkpoint)){
+				printf("WARNING: Could not write checkpoint %s\n", _options_.checkpoint);
+			}
+			next = wall_time() + _options_.checkpoint_interval;
+		}
+		_stats_.nodes += search->states;
+		_stats_.backtracks += search->backtracks;
+		_stats_.propagations += search->propagations;
+	}
+	if (status == SEARCH_SOLVED){
+		store_values(puzzle);
+	}
+
+	// nothing is left to resume
+	remove(_options_.checkpoint);
+	search_free(search);
+	checkpoint_free(saved);
+	checkpoint_free(work);
+	return status == SEARCH_SOLVED || _leaf_.solved;
+}
+
+/**
+ * Spawn hook of the search of solve_resumable: a branch leaving few enough
+ * empty cells is searched whole by the kernel, which copies the solution
+ * into the board of the puzzle if it finds one. The limit starts at
+ * --cutoff and follows the time the kernel takes (checkpoint_leaf_solve).
+ *
+ * @param search Search trying the branch.
+ * @param cell Cell of the branch.
+ * @param number Number of the branch.
+ * @param data Sudoku puzzle data structure being searched.
+ * @return Returns non-zero if the branch was taken out of the search.
+ */
+int solve_leaf(Search * search, int cell, int number, void * data){
+	Puzzle * puzzle = data;
+	return checkpoint_leaf_solve(&_leaf_, search, cell, number, puzzle->board->cells, &_options_, &_stats_, NULL, NULL);
+}
+
+/**
+ * Attemp to solve the sudoku puzzle using recursive backtracking over the
+ * matrix, checking every number with the row, column and grid scans.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns true if the sudoku has a solution.
+ */
+bool solve_scan(Puzzle * puzzle){
+    _stats_.nodes++;
 	int i, row = 0, column = 0;
 
 	// Check if puzzle is complete
@@ -307,28 +505,99 @@ bool solve(Puzzle * puzzle){
 
 		// Check if number can be placed in a cell
 		if (is_valid(puzzle, row, column, i)){
-			puzzle->matrix[row][column] = i;
+			board_set(puzzle->board, row, column, i);
 
             // call solve with the new value on the sudoku puzzle
-			if (solve(puzzle)){
+			if (solve_scan(puzzle)){
                 // solution found
 				return true;
 			}
 
             // if the change didn't led to a solution set it to zero to be changed by other value
-			puzzle->matrix[row][column] = 0;
+			board_set(puzzle->board, row, column, 0);
 		}
 	}
     // no solution found
+	_stats_.backtracks++;
 	return false;
 }
 
+/**
+ * Attemp to solve the sudoku puzzle with the dancing links exact cover search.
+ * 
+ * @param puzzle Sudoku puzzle data structure.
+ * @return Returns true if the sudoku has a solution.
+ */
+bool solve_dlx(Puzzle * puzzle){
+	Dlx * dlx = dlx_create(puzzle->root_n, puzzle->board->cells);
+	if (dlx == NULL){
+		return false;
+	}
+	bool solved = dlx_solve(dlx, puzzle->board->cells);
+	_stats_.nodes += dlx->states;
+	_stats_.backtracks += dlx->backtracks;
+	dlx_free(dlx);
+	return solved;
+}
+
+/**
+ * Solves every puzzle of a batch file one after the other, reusing one
+ * set of buffers, and prints the solutions in the order of the file
+ * followed by the puzzles solved per second.
+ */
+void solve_batch(){
+	FILE * file_input = fopen(_options_.filename, "r");
+	if (file_input == NULL){
+		printf("ERROR: Could not open file %s\n", _options_.filename);
+		exit(EXIT_FAILURE);
+	}
+	Puzzles * puzzles = puzzles_read(file_input);
+	fclose(file_input);
+	if (puzzles == NULL){
+		printf("ERROR: Could not read puzzles from file %s\n", _options_.filename);
+		exit(EXIT_FAILURE);
+	}
+
+	PuzzlesScratch * scratch = puzzles_scratch_create();
+	int index;
+	for (index = 0; index < puzzles->count; ++index){
+		puzzles_solve(puzzles, index, scratch, &_options_, &_stats_);
+	}
+	_end_ = wall_time();
+
+	puzzles_report(stdout, puzzles, &_options_, _end_ - _start_);
+	if (_options_.stats == STATS_JSON) {
+		stats_print_json(stdout, "serial", &_stats_, 1, puzzles_solved(puzzles) == puzzles->count, _end_ - _start_);
+	}
+	puzzles_scratch_free(scratch);
+	puzzles_free(puzzles);
+}
+
 /**
  * Prints the sudoku puzzle solved and the time accordingly to the flags passed as arguments.
  * 
  * @param puzzle Sudoku puzzle data structure.
  */
-void end_on_solution_found(Puzzle * puzzle) {
-    debug_puzzle(puzzle);
-    exit(EXIT_SUCCESS);
+void print_solution(Puzzle * puzzle) {
+    _end_ = wall_time();
+    if (_options_.time_only_flag) {
+        printf("Elapsed time: %f (s)\n", _end_ - _start_);
+    } else if (_options_.time_flag) {
+        debug_puzzle(puzzle);
+        printf("Searched %ld states in total.\n", _stats_.nodes);
+        printf("Elapsed time: %f (s)\n", _end_ - _start_);
+    } else {
+        debug_puzzle(puzzle);
+    }
+}
+
+/**
+ * Current time of a monotonic clock.
+ * 
+ * @return Returns the time in seconds.
+ */
+double wall_time() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
 }
\ No newline at end of file
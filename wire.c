@@ -0,0 +1,129 @@
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <string.h>
+
+#include "wire.h"
+
+
+/**
+ * Largest message of a board, its header and every cell.
+ *
+ * @param root_n Square root of the number of rows and columns.
+ * @return Returns the bytes a buffer needs to hold any message of the board.
+ */
+size_t wire_capacity(int root_n){
+    int n = root_n * root_n;
+    return sizeof(WireHeader) + (size_t) n * n;
+}
+
+/**
+ * Writes the message of a work item or a solution, as the cells that
+ * differ from the given puzzle if that is shorter than every cell.
+ *
+ * @param buffer Buffer of wire_capacity bytes at least.
+ * @param given Puzzle every rank holds.
+ * @param cells Cells of the work item, same size as the given puzzle.
+ * @param depth Decisions taken from the given puzzle.
+ * @return Returns the bytes written.
+ */
+size_t wire_encode(uint8_t * buffer, Board * given, uint8_t * cells, int depth){
+    int cell, size = given->n * given->n, changed = 0;
+    for (cell = 0; cell < size; ++cell){
+        changed += cells[cell] != given->cells[cell];
+    }
+
+    WireHeader header;
+    header.depth = depth > UINT16_MAX ? UINT16_MAX : depth;
+    header.root_n = given->root_n;
+    uint8_t * body = buffer + sizeof(WireHeader);
+
+    if (changed * WIRE_ASSIGNMENT_BYTES < size){
+        header.format = WIRE_ASSIGNMENTS;
+        header.count = changed;
+        for (cell = 0; cell < size; ++cell){
+            if (cells[cell] != given->cells[cell]){
+                body[0] = cell & 0xff;
+                body[1] = cell >> 8;
+                body[2] = cells[cell];
+                body += WIRE_ASSIGNMENT_BYTES;
+            }
+        }
+    } else {
+        header.format = WIRE_CELLS;
+        header.count = size;
+        memcpy(body, cells, size);
+        body += size;
+    }
+    memcpy(buffer, &header, sizeof(WireHeader));
+    return body - buffer;
+}
+
+/**
+ * Reads the message of a work item or a solution.
+ *
+ * @param buffer Message received.
+ * @param size Bytes of the message.
+ * @param given Puzzle every rank holds.
+ * @param cells Cells to fill, same size as the given puzzle.
+ * @param depth Set to the decisions taken from the given puzzle, or NULL.
+ * @return Returns zero if the message is not one of a board of the given size.
+ */
+int wire_decode(uint8_t * buffer, size_t size, Board * given, uint8_t * cells, int * depth){
+    WireHeader header;
+    if (size < sizeof(WireHeader)){
+        return 0;
+    }
+    memcpy(&header, buffer, sizeof(WireHeader));
+    uint8_t * body = buffer + sizeof(WireHeader);
+    size -= sizeof(WireHeader);
+    int cells_count = given->n * given->n;
+
+    if (header.root_n != given->root_n){
+        return 0;
+    }
+    if (header.format == WIRE_CELLS){
+        if (header.count != (uint32_t) cells_count || size != (size_t) cells_count){
+            return 0;
+        }
+        memcpy(cells, body, cells_count);
+    } else if (header.format == WIRE_ASSIGNMENTS){
+        if (size != (size_t) header.count * WIRE_ASSIGNMENT_BYTES){
+            return 0;
+        }
+        memcpy(cells, given->cells, cells_count);
+        uint32_t i;
+        for (i = 0; i < header.count; ++i, body += WIRE_ASSIGNMENT_BYTES){
+            int cell = body[0] | body[1] << 8;
+            if (cell >= cells_count || body[2] > given->n){
+                return 0;
+            }
+            cells[cell] = body[2];
+        }
+    } else {
+        return 0;
+    }
+
+    if (depth != NULL){
+        *depth = header.depth;
+    }
+    return 1;
+}
+
+/**
+ * Bytes of the first message of a buffer holding several back to back, as
+ * a batch of work items is sent.
+ *
+ * @param buffer Messages received.
+ * @param size Bytes left in the buffer.
+ * @return Returns the bytes of the first message, zero if the buffer is too short to hold it.
+ */
+size_t wire_size(uint8_t * buffer, size_t size){
+    WireHeader header;
+    if (size < sizeof(WireHeader)){
+        return 0;
+    }
+    memcpy(&header, buffer, sizeof(WireHeader));
+    size_t bytes = sizeof(WireHeader) + (size_t) header.count * (header.format == WIRE_ASSIGNMENTS ? WIRE_ASSIGNMENT_BYTES : 1);
+    return bytes <= size ? bytes : 0;
+}
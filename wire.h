@@ -0,0 +1,53 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+////////////////////////////////////////////////////////////
+//// Includes
+////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stddef.h>
+
+#include "board.h"
+
+
+////////////////////////////////////////////////////////////
+//// Defines
+////////////////////////////////////////////////////////////
+// every cell follows the header, one byte each
+#define WIRE_CELLS 0
+// only the cells filled since the given puzzle follow, three bytes each
+#define WIRE_ASSIGNMENTS 1
+// bytes of an assignment: the index of the cell, low byte first, and its number
+#define WIRE_ASSIGNMENT_BYTES 3
+
+
+////////////////////////////////////////////////////////////
+//// Structures
+////////////////////////////////////////////////////////////
+/**
+ * Header of a work item or a solution sent between ranks. Every rank holds
+ * the given puzzle, so a work item is usually sent as the few cells filled
+ * since, and as all its cells only once that takes fewer bytes. Boards are
+ * at most 225x225, so the index of a cell fits in two bytes.
+ */
+struct WireHeader {
+    // decisions taken from the given puzzle to reach the work item
+    uint16_t depth;
+    uint8_t root_n;
+    uint8_t format;
+    // cells or assignments after the header
+    uint32_t count;
+};
+
+typedef struct WireHeader WireHeader;
+
+
+////////////////////////////////////////////////////////////
+//// Function Prototypes
+////////////////////////////////////////////////////////////
+size_t wire_capacity(int root_n);
+size_t wire_encode(uint8_t * buffer, Board * given, uint8_t * cells, int depth);
+int wire_decode(uint8_t * buffer, size_t size, Board * given, uint8_t * cells, int * depth);
+size_t wire_size(uint8_t * buffer, size_t size);
+
+#endif